@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace batch {
+namespace detail {
+// Whether `name` matches `pattern`, where '*' is any run of characters and '?'
+// any single character.
+inline bool Matches(std::string_view pattern, std::string_view name) {
+  std::size_t pattern_index{};
+  std::size_t name_index{};
+  std::optional<std::size_t> star{};
+  std::size_t star_name_index{};
+
+  while (name_index < name.size()) {
+    if (pattern_index < pattern.size() &&
+        (pattern[pattern_index] == '?' || pattern[pattern_index] == name[name_index])) {
+      pattern_index++;
+      name_index++;
+    } else if (pattern_index < pattern.size() && pattern[pattern_index] == '*') {
+      star = pattern_index++;
+      star_name_index = name_index;
+    } else if (star) {
+      pattern_index = *star + 1;
+      name_index = ++star_name_index;
+    } else {
+      return false;
+    }
+  }
+
+  while (pattern_index < pattern.size() && pattern[pattern_index] == '*') {
+    pattern_index++;
+  }
+
+  return pattern_index == pattern.size();
+}
+
+inline void AddDirectory(const std::filesystem::path& directory, std::string_view pattern,
+                         std::vector<std::filesystem::path>& inputs) {
+  std::vector<std::filesystem::path> matches{};
+  std::error_code error{};
+
+  for (const auto& entry : std::filesystem::directory_iterator{directory, error}) {
+    if (entry.is_regular_file() && Matches(pattern, entry.path().filename().string())) {
+      matches.push_back(entry.path());
+    }
+  }
+
+  std::sort(matches.begin(), matches.end());
+  inputs.insert(inputs.end(), matches.begin(), matches.end());
+}
+}  // namespace detail
+
+// Expands every argument into input files, keeping the argument order: a file
+// is taken as is, a directory gives its regular files and a '*' or '?' in the
+// file name part selects the matching files of its directory (so quoted globs
+// work without a shell). Expanded entries are sorted by path.
+inline std::vector<std::filesystem::path> ExpandInputs(const std::vector<std::string>& arguments) {
+  std::vector<std::filesystem::path> inputs{};
+
+  for (const auto& argument : arguments) {
+    const std::filesystem::path path{argument};
+    const auto name{path.filename().string()};
+
+    if (name.find_first_of("*?") != std::string::npos) {
+      detail::AddDirectory(path.has_parent_path() ? path.parent_path() : ".", name, inputs);
+    } else if (std::filesystem::is_directory(path)) {
+      detail::AddDirectory(path, "*", inputs);
+    } else {
+      inputs.push_back(path);
+    }
+  }
+
+  return inputs;
+}
+
+// Runs `process(input, output) -> bool` for every input on `thread_count`
+// threads and writes each input's output to `output` in input order, as soon
+// as all the inputs before it are written. At most `window` inputs are loaded
+// or waiting to be written at any time, which bounds memory whatever the
+// number of inputs. Per-input outputs use the locale of `output`.
+//
+// Returns how many inputs failed (`process` returned false).
+template <typename Process>
+std::size_t Run(const std::vector<std::filesystem::path>& inputs, std::size_t thread_count,
+                std::size_t window, Process process, std::ostream& output) {
+  struct Result {
+    std::string text;
+    bool succeeded;
+  };
+
+  window = std::max<std::size_t>(window, 1);
+  thread_count = std::clamp<std::size_t>(thread_count, 1, std::max<std::size_t>(inputs.size(), 1));
+
+  std::vector<std::optional<Result>> slots(window);
+  std::size_t next_claim{};
+  std::size_t next_write{};
+
+  std::mutex mutex{};
+  std::condition_variable claimable{};
+  std::condition_variable writable{};
+
+  auto work = [&] {
+    std::unique_lock lock{mutex};
+
+    while (true) {
+      claimable.wait(lock, [&] {
+        return next_claim >= inputs.size() || next_claim < next_write + window;
+      });
+
+      if (next_claim >= inputs.size()) {
+        return;
+      }
+
+      const auto index{next_claim++};
+      lock.unlock();
+
+      std::ostringstream text_stream{};
+      text_stream.imbue(output.getloc());
+
+      const bool succeeded{process(inputs[index], text_stream)};
+
+      lock.lock();
+      slots[index % window] = Result{text_stream.str(), succeeded};
+      writable.notify_one();
+    }
+  };
+
+  std::vector<std::jthread> threads{};
+  for (std::size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(work);
+  }
+
+  std::size_t failures{};
+
+  for (std::unique_lock lock{mutex}; next_write < inputs.size();) {
+    auto& slot{slots[next_write % window]};
+    writable.wait(lock, [&] { return slot.has_value(); });
+
+    const auto result{std::move(*slot)};
+    slot.reset();
+
+    lock.unlock();
+    output << result.text;
+    failures += result.succeeded ? 0 : 1;
+    lock.lock();
+
+    next_write++;
+    claimable.notify_all();
+  }
+
+  output.flush();
+  return failures;
+}
+}  // namespace batch
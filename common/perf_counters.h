@@ -0,0 +1,174 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace perf {
+enum class Event {
+  kCycles,
+  kInstructions,
+  kCacheMisses,
+  kBranchMisses,
+};
+
+// Counts of one measured region; an event the kernel or the CPU does not
+// provide is left empty.
+struct Sample {
+  std::optional<std::uint64_t> cycles;
+  std::optional<std::uint64_t> instructions;
+  std::optional<std::uint64_t> cache_misses;
+  std::optional<std::uint64_t> branch_misses;
+
+  std::optional<double> Ipc() const {
+    if (!cycles || !instructions || *cycles == 0) {
+      return std::nullopt;
+    }
+
+    return static_cast<double>(*instructions) / static_cast<double>(*cycles);
+  }
+};
+
+// Hardware counters of the calling thread, in user space only, through
+// perf_event_open(2). The events are opened once as a group so that they are
+// scheduled onto the PMU together, and every Start/Stop pair measures one
+// region:
+//
+//   perf::Counters counters{};
+//   counters.Start();
+//   scheduler.Start();
+//   const auto sample{counters.Stop()};
+//
+// When the kernel refuses (perf_event_paranoid, seccomp, no PMU in a VM),
+// available() is false, error() says why and Stop returns an empty sample.
+class Counters {
+ public:
+  Counters() {
+    for (std::size_t i = 0; i < kEvents.size(); i++) {
+      descriptors_[i] = Open(kEvents[i], descriptors_[0]);
+
+      if (descriptors_[i] < 0 && error_.empty()) {
+        error_ = std::strerror(errno);
+      }
+
+      // Without the group leader nothing else can be counted.
+      if (i == 0 && descriptors_[0] < 0) {
+        return;
+      }
+    }
+  }
+
+  Counters(const Counters&) = delete;
+  Counters& operator=(const Counters&) = delete;
+
+  ~Counters() {
+    for (const int descriptor : descriptors_) {
+      if (descriptor >= 0) {
+        close(descriptor);
+      }
+    }
+  }
+
+  // Whether at least the cycle counter could be opened.
+  bool available() const { return descriptors_[0] >= 0; }
+
+  // Why the first event that failed to open was refused, if one did.
+  const std::string& error() const { return error_; }
+
+  void Start() {
+    if (!available()) {
+      return;
+    }
+
+    ioctl(descriptors_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(descriptors_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  Sample Stop() {
+    if (!available()) {
+      return {};
+    }
+
+    ioctl(descriptors_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    return {.cycles = Read(Event::kCycles),
+            .instructions = Read(Event::kInstructions),
+            .cache_misses = Read(Event::kCacheMisses),
+            .branch_misses = Read(Event::kBranchMisses)};
+  }
+
+ private:
+  static constexpr std::array<std::uint64_t, 4> kEvents{
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+
+  static int Open(std::uint64_t config, int group_leader) {
+    perf_event_attr attributes{};
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.disabled = group_leader < 0 ? 1 : 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group_leader, 0));
+  }
+
+  std::optional<std::uint64_t> Read(Event event) const {
+    const int descriptor{descriptors_[static_cast<std::size_t>(event)]};
+
+    std::uint64_t value{};
+    if (descriptor < 0 || read(descriptor, &value, sizeof(value)) != sizeof(value)) {
+      return std::nullopt;
+    }
+
+    return value;
+  }
+
+  std::array<int, kEvents.size()> descriptors_{-1, -1, -1, -1};
+  std::string error_{};
+};
+
+// "ipc 1.85 cache-misses/page 0.12 branch-misses/page 0.40", per `items`
+// processed in the region ("n/a" for the events that were not counted).
+inline void Print(std::ostream& stream, const Sample& sample, std::uint64_t items,
+                  std::string_view item_name) {
+  const auto per_item = [&](std::string_view name, const std::optional<std::uint64_t>& count) {
+    stream << " " << name << "/" << item_name << " ";
+
+    if (count && items > 0) {
+      stream << static_cast<double>(*count) / static_cast<double>(items);
+    } else {
+      stream << "n/a";
+    }
+  };
+
+  const auto flags{stream.flags()};
+  const auto precision{stream.precision()};
+
+  stream << std::fixed << std::setprecision(2) << "ipc ";
+
+  if (const auto ipc{sample.Ipc()}) {
+    stream << *ipc;
+  } else {
+    stream << "n/a";
+  }
+
+  per_item("cache-misses", sample.cache_misses);
+  per_item("branch-misses", sample.branch_misses);
+
+  stream.flags(flags);
+  stream.precision(precision);
+}
+}  // namespace perf
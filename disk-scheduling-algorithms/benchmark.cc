@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "disk_scheduler.h"
+
+namespace {
+// `state.range(0)` requests spread uniformly over 2^20 positions, arriving
+// every `state.range(1)` time units on average (all at once with 0, so the
+// whole trace is queued).
+std::vector<ds::Request> MakeRequests(const benchmark::State& state) {
+  std::mt19937_64 engine{42};
+  std::uniform_int_distribution<ds::Position> position{0, (1 << 20) - 1};
+  std::uniform_int_distribution<ds::Time> gap{0, 2 * state.range(1)};
+
+  std::vector<ds::Request> requests{};
+  ds::Time at{};
+
+  for (std::int64_t i = 0; i < state.range(0); i++) {
+    at += gap(engine);
+    requests.push_back({.at = at,
+                        .position = position(engine),
+                        .size = 8,
+                        .id = static_cast<std::size_t>(i)});
+  }
+
+  return requests;
+}
+
+template <typename Policy>
+void RunScheduler(benchmark::State& state, Policy policy = {}) {
+  const auto requests{MakeRequests(state)};
+  ds::DiskScheduler scheduler{requests, policy, ds::DiskModel{.seek_rate = 4096}};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scheduler.Start());
+  }
+
+  state.counters["seek"] = static_cast<double>(scheduler.metrics().seek) /
+                           static_cast<double>(requests.size());
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_FCFS(benchmark::State& state) { RunScheduler<ds::FCFSPolicy>(state); }
+
+void BM_SSTF(benchmark::State& state) { RunScheduler<ds::SSTFPolicy>(state); }
+
+void BM_SCAN(benchmark::State& state) { RunScheduler(state, ds::SCANPolicy{(1 << 20) - 1}); }
+
+void BM_CLOOK(benchmark::State& state) { RunScheduler<ds::CLOOKPolicy>(state); }
+
+void BM_Deadline(benchmark::State& state) { RunScheduler(state, ds::DeadlinePolicy{}); }
+
+// n x mean arrival gap.
+void TraceArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"n", "gap"})->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 8}});
+}
+}  // namespace
+
+BENCHMARK(BM_FCFS)->Apply(TraceArguments);
+BENCHMARK(BM_SSTF)->Apply(TraceArguments);
+BENCHMARK(BM_SCAN)->Apply(TraceArguments);
+BENCHMARK(BM_CLOOK)->Apply(TraceArguments);
+BENCHMARK(BM_Deadline)->Apply(TraceArguments);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "../process-scheduling-algorithms/histogram.h"
+
+namespace ds {
+using Time = std::int64_t;
+using Position = std::uint64_t;  // Cylinder or logical block address
+
+struct Request {
+  Time at;            // Arrival time
+  Position position;  // Cylinder or LBA
+  std::uint32_t size;  // Transfer size (sectors, blocks...)
+  Time st;            // Start time (the head starts to seek)
+  Time ct;            // Completion time (start time + seek time + transfer time)
+  Time lt;            // Latency (completion time - arrival time)
+  Time wt;            // Wait time (start time - arrival time)
+  Position seek;      // Head movement to reach it
+  std::size_t id;     // Position in the input (used as last tie-breaker)
+};
+
+// Service time of a request: a head that moves settles and then crosses
+// `seek_rate` positions per time unit, then the transfer takes `transfer` per
+// unit of size.
+struct DiskModel {
+  Time settle{0};
+  Position seek_rate{1};
+  Time transfer{1};
+
+  constexpr Time Service(Position distance, std::uint32_t size) const {
+    const Time seek{distance == 0 ? 0
+                                  : settle + static_cast<Time>((distance + seek_rate - 1) /
+                                                               std::max<Position>(seek_rate, 1))};
+    return seek + static_cast<Time>(size) * transfer;
+  }
+};
+
+struct DiskAverageMetrics {
+  float seek;
+  float lt;
+  float wt;
+};
+
+struct DiskHistograms {
+  ps::LatencyHistogram seek;
+  ps::LatencyHistogram lt;
+  ps::LatencyHistogram wt;
+};
+
+// Receives every request as it completes.
+struct DiskMetricsSink {
+  void Record(const Request& request) {
+    seek += request.seek;
+    lt += static_cast<double>(request.lt);
+    wt += static_cast<double>(request.wt);
+    count++;
+
+    histograms.seek.Record(static_cast<std::int64_t>(request.seek));
+    histograms.lt.Record(request.lt);
+    histograms.wt.Record(request.wt);
+  }
+
+  void Reset() {
+    seek = 0;
+    lt = 0;
+    wt = 0;
+    count = 0;
+
+    histograms.seek.Reset();
+    histograms.lt.Reset();
+    histograms.wt.Reset();
+  }
+
+  DiskAverageMetrics Average() const {
+    if (count == 0) {
+      return {};
+    }
+
+    const auto divisor{static_cast<double>(count)};
+    return {static_cast<float>(static_cast<double>(seek) / divisor),
+            static_cast<float>(lt / divisor), static_cast<float>(wt / divisor)};
+  }
+
+  Position seek{};  // Total head movement
+  double lt{};
+  double wt{};
+  std::size_t count{};
+  DiskHistograms histograms{};
+};
+
+// A queued request, with what the policies order it by.
+struct PendingRequest {
+  Position position;
+  Time at;
+  std::size_t index;  // In the scheduler's table, which is in arrival order
+};
+
+struct ByPosition {
+  constexpr bool operator()(const PendingRequest& lhs, const PendingRequest& rhs) const {
+    return lhs.position < rhs.position || (lhs.position == rhs.position && lhs.index < rhs.index);
+  }
+};
+
+struct ByArrival {
+  constexpr bool operator()(const PendingRequest& lhs, const PendingRequest& rhs) const {
+    return lhs.at < rhs.at || (lhs.at == rhs.at && lhs.index < rhs.index);
+  }
+};
+
+// Ordered by position, so the nearest request on either side of the head is
+// found in O(log n).
+using PositionIndex = std::set<PendingRequest, ByPosition>;
+
+// The request to serve next and how far the head travels to reach it.
+struct Dispatch {
+  std::size_t index;
+  Position distance;
+};
+
+constexpr Position Distance(Position from, Position to) {
+  return from < to ? to - from : from - to;
+}
+
+// The earliest arrival at `position`, the first of its requests in the index.
+inline PositionIndex::iterator FirstAt(PositionIndex& index, Position position) {
+  return index.lower_bound({position, 0, 0});
+}
+
+// Policies keep the queued requests and pick the next one to serve, given the
+// head position and the clock: Push, empty, Pop and Clear.
+
+// First come first serve: arrival order.
+class FCFSPolicy {
+ public:
+  void Push(const PendingRequest& request) { queue_.push_back(request); }
+  bool empty() const { return queue_.empty(); }
+  void Clear() { queue_.clear(); }
+
+  Dispatch Pop(Position head, Time) {
+    const auto request{queue_.front()};
+    queue_.pop_front();
+
+    return {request.index, Distance(head, request.position)};
+  }
+
+ private:
+  std::deque<PendingRequest> queue_{};
+};
+
+// Shortest seek time first: the request nearest to the head, the earliest
+// arrival on a tie.
+class SSTFPolicy {
+ public:
+  void Push(const PendingRequest& request) { pending_.insert(request); }
+  bool empty() const { return pending_.empty(); }
+  void Clear() { pending_.clear(); }
+
+  Dispatch Pop(Position head, Time) {
+    auto nearest{FirstAt(pending_, head)};
+
+    if (nearest == pending_.end()) {
+      nearest = FirstAt(pending_, std::prev(nearest)->position);
+    } else if (nearest != pending_.begin()) {
+      const auto below{FirstAt(pending_, std::prev(nearest)->position)};
+
+      const auto below_distance{head - below->position};
+      const auto above_distance{nearest->position - head};
+
+      if (below_distance < above_distance ||
+          (below_distance == above_distance && below->index < nearest->index)) {
+        nearest = below;
+      }
+    }
+
+    const Dispatch dispatch{nearest->index, Distance(head, nearest->position)};
+    pending_.erase(nearest);
+
+    return dispatch;
+  }
+
+ private:
+  PositionIndex pending_{};
+};
+
+// Elevator: sweeps up to the last position (or the highest request beyond
+// it), then down to position 0, serving the requests on the way.
+class SCANPolicy {
+ public:
+  explicit SCANPolicy(Position last_position = 0) : last_position_{last_position} {}
+
+  void Push(const PendingRequest& request) { pending_.insert(request); }
+  bool empty() const { return pending_.empty(); }
+  void Clear() {
+    pending_.clear();
+    up_ = true;
+  }
+
+  Dispatch Pop(Position head, Time) {
+    if (up_) {
+      if (const auto next{FirstAt(pending_, head)}; next != pending_.end()) {
+        return Take(next, next->position - head);
+      }
+
+      // Nothing ahead: on to the end, then back down to the highest request.
+      up_ = false;
+
+      const auto next{FirstAt(pending_, std::prev(pending_.end())->position)};
+      const auto end{std::max({last_position_, head, next->position})};
+
+      return Take(next, (end - head) + (end - next->position));
+    }
+
+    if (const auto after{pending_.upper_bound({head, std::numeric_limits<Time>::max(),
+                                               std::numeric_limits<std::size_t>::max()})};
+        after != pending_.begin()) {
+      const auto next{FirstAt(pending_, std::prev(after)->position)};
+      return Take(next, head - next->position);
+    }
+
+    up_ = true;
+
+    const auto next{pending_.begin()};
+    return Take(next, head + next->position);
+  }
+
+ private:
+  Dispatch Take(PositionIndex::iterator request, Position distance) {
+    const Dispatch dispatch{request->index, distance};
+    pending_.erase(request);
+
+    return dispatch;
+  }
+
+  PositionIndex pending_{};
+  Position last_position_;
+  bool up_{true};
+};
+
+// Circular LOOK: sweeps up to the highest request, then jumps back to the
+// lowest one, so every position waits at most one sweep.
+class CLOOKPolicy {
+ public:
+  void Push(const PendingRequest& request) { pending_.insert(request); }
+  bool empty() const { return pending_.empty(); }
+  void Clear() { pending_.clear(); }
+
+  Dispatch Pop(Position head, Time) {
+    auto next{FirstAt(pending_, head)};
+    if (next == pending_.end()) {
+      next = pending_.begin();
+    }
+
+    const Dispatch dispatch{next->index, Distance(head, next->position)};
+    pending_.erase(next);
+
+    return dispatch;
+  }
+
+ private:
+  PositionIndex pending_{};
+};
+
+// Deadline: C-LOOK order, except that a request that has waited `expire` is
+// served first, and the sweep goes on from there. Bounds the starvation of
+// requests far from a busy region.
+class DeadlinePolicy {
+ public:
+  explicit DeadlinePolicy(Time expire = 500) : expire_{std::max<Time>(expire, 0)} {}
+
+  void Push(const PendingRequest& request) {
+    by_position_.insert(request);
+    by_arrival_.insert(request);
+  }
+
+  bool empty() const { return by_position_.empty(); }
+
+  void Clear() {
+    by_position_.clear();
+    by_arrival_.clear();
+  }
+
+  Dispatch Pop(Position head, Time clock) {
+    PendingRequest request{};
+
+    if (const auto& oldest{*by_arrival_.begin()}; oldest.at + expire_ <= clock) {
+      request = oldest;
+    } else {
+      auto next{FirstAt(by_position_, head)};
+      if (next == by_position_.end()) {
+        next = by_position_.begin();
+      }
+
+      request = *next;
+    }
+
+    by_position_.erase(request);
+    by_arrival_.erase(request);
+
+    return {request.index, Distance(head, request.position)};
+  }
+
+  Time expire() const { return expire_; }
+
+ private:
+  PositionIndex by_position_{};
+  std::set<PendingRequest, ByArrival> by_arrival_{};
+  Time expire_;
+};
+
+// Single disk scheduler: requests are queued to the policy as the clock
+// reaches their arrival, and one is served at a time, from wherever the head
+// stopped last. The policy decides when the head is free, so requests that
+// arrive during a seek wait for the next decision.
+template <typename Policy, typename Sink = DiskMetricsSink>
+class DiskScheduler {
+ public:
+  // `requests` is any range of requests with at, position, size and id.
+  template <std::ranges::input_range Requests>
+  explicit DiskScheduler(const Requests& requests, Policy policy = {}, DiskModel model = {},
+                         Position head = 0)
+      : policy_{std::move(policy)}, model_{model}, initial_head_{head} {
+    for (const auto& request : requests) {
+      requests_.push_back(
+          {.at = request.at, .position = request.position, .size = request.size, .id = request.id});
+    }
+  }
+
+  DiskAverageMetrics Start() {
+    std::sort(requests_.begin(), requests_.end(), [](const Request& lhs, const Request& rhs) {
+      return lhs.at < rhs.at || (lhs.at == rhs.at && lhs.id < rhs.id);
+    });
+
+    policy_.Clear();
+    sink_.Reset();
+
+    Time clock{};
+    Position head{initial_head_};
+    std::size_t next_arrival{};
+
+    const auto admit = [&] {
+      while (next_arrival < requests_.size() && requests_[next_arrival].at <= clock) {
+        const auto& request{requests_[next_arrival]};
+
+        policy_.Push({.position = request.position, .at = request.at, .index = next_arrival});
+        next_arrival++;
+      }
+    };
+
+    for (std::size_t served = 0; served < requests_.size(); served++) {
+      admit();
+
+      if (policy_.empty()) {
+        clock = requests_[next_arrival].at;
+        admit();
+      }
+
+      const auto dispatch{policy_.Pop(head, clock)};
+      auto& request{requests_[dispatch.index]};
+
+      request.st = clock;
+      request.seek = dispatch.distance;
+
+      clock += model_.Service(dispatch.distance, request.size);
+      head = request.position;
+
+      request.ct = clock;
+      request.lt = request.ct - request.at;
+      request.wt = request.st - request.at;
+
+      sink_.Record(request);
+    }
+
+    return sink_.Average();
+  }
+
+  // Requests in arrival order, with the results of the last Start.
+  const std::vector<Request>& requests() const { return requests_; }
+
+  const Sink& metrics() const { return sink_; }
+
+  const DiskHistograms& histograms() const { return sink_.histograms; }
+
+ private:
+  std::vector<Request> requests_{};
+  Policy policy_;
+  DiskModel model_;
+  Sink sink_{};
+  Position initial_head_;
+};
+}  // namespace ds
@@ -0,0 +1,301 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/batch.h"
+#include "disk_scheduler.h"
+
+// Custom numeric separator (",") for std output.
+class NumericSeparator : public std::numpunct<char> {
+  char do_decimal_point() const override { return ','; }
+};
+
+struct Options {
+  std::filesystem::path filepath;
+  std::vector<double> percentiles{50.0, 99.0, 99.9};
+  ds::Position head;           // Head position before the first request
+  ds::Position last_position;  // Where SCAN turns around, the highest request if lower
+  ds::Time expire{500};        // Deadline of a request, after its arrival
+  ds::DiskModel model;
+  bool batch;                                // Every input below, with no interaction
+  std::vector<std::string> batch_inputs;     // Files, directories or globs
+  std::filesystem::path output_filepath;     // Batch results, standard output if empty
+  std::size_t threads;                       // Batch threads, 0 for every hardware thread
+};
+
+std::optional<Options> ParseOptions(int argc, char** argv);
+
+// Runs every algorithm on the requests.
+void RunSchedulers(const std::vector<ds::Request>& requests, const Options& options,
+                   std::ostream& output);
+
+// Schedules every batch input on a thread pool into one ordered output.
+int RunBatch(const Options& options);
+
+// Prints the total head movement and averages, then one line of percentiles
+// per requested percentile.
+void PrintMetrics(std::ostream& output, const std::string& name, const ds::DiskMetricsSink& metrics,
+                  const Options& options);
+
+std::optional<std::vector<ds::Request>> ParseFile(const std::filesystem::path& filepath);
+
+int main(int argc, char** argv) {
+  std::cout.imbue(std::locale(std::cout.getloc(), new NumericSeparator));
+
+  const auto options{ParseOptions(argc, argv)};
+  if (!options) {
+    std::cout << "Usage: "
+              << std::filesystem::path(argv[0]).filename().string()
+              << " [requests file] [--percentiles=50,99,99.9] [--head=0] [--cylinders=count]\n"
+              << "       [--expire=500] [--settle=0] [--seek-rate=1] [--transfer=1]\n"
+              << "       [--batch files, directories or globs... [--output=file] [--threads=0]]"
+              << std::endl;
+
+    std::cin.get();
+    return EXIT_SUCCESS;
+  }
+
+  if (options->batch) {
+    return RunBatch(*options);
+  }
+
+  if (!std::filesystem::exists(options->filepath)) {
+    std::cerr << "File not found: " + options->filepath.string() << std::endl;
+
+    std::cin.get();
+    return EXIT_FAILURE;
+  }
+
+  const auto requests{ParseFile(options->filepath)};
+  if (!requests) {
+    std::cerr << "Unable to read: " + options->filepath.string() << std::endl;
+
+    std::cin.get();
+    return EXIT_FAILURE;
+  }
+
+  if (requests->empty()) {
+    std::cout << "No request to schedule." << std::endl;
+
+    std::cin.get();
+    return EXIT_SUCCESS;
+  }
+
+  RunSchedulers(*requests, *options, std::cout);
+
+  std::cin.get();
+}
+
+void RunSchedulers(const std::vector<ds::Request>& requests, const Options& options,
+                   std::ostream& output) {
+  const auto report = [&](const std::string& name, auto&& scheduler) {
+    scheduler.Start();
+    PrintMetrics(output, name, scheduler.metrics(), options);
+  };
+
+  const auto disk = [&](auto policy) {
+    return ds::DiskScheduler{requests, policy, options.model, options.head};
+  };
+
+  report("FCFS", disk(ds::FCFSPolicy{}));
+  report("SSTF", disk(ds::SSTFPolicy{}));
+  report("SCAN", disk(ds::SCANPolicy{options.last_position}));
+  report("C-LOOK", disk(ds::CLOOKPolicy{}));
+  report("Deadline", disk(ds::DeadlinePolicy{options.expire}));
+}
+
+int RunBatch(const Options& options) {
+  const auto inputs{batch::ExpandInputs(options.batch_inputs)};
+
+  std::ofstream file_stream{};
+  if (!options.output_filepath.empty()) {
+    file_stream.open(options.output_filepath, std::ios::out | std::ios::trunc);
+
+    if (!file_stream) {
+      std::cerr << "Unable to write results: " + options.output_filepath.string() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    file_stream.imbue(std::cout.getloc());
+  }
+
+  auto& output{options.output_filepath.empty() ? static_cast<std::ostream&>(std::cout)
+                                               : file_stream};
+
+  const auto thread_count{options.threads > 0
+                              ? options.threads
+                              : std::max<std::size_t>(std::thread::hardware_concurrency(), 1)};
+
+  const auto failures{batch::Run(
+      inputs, thread_count, 2 * thread_count,
+      [&](const std::filesystem::path& filepath, std::ostream& result) {
+        result << "== " << filepath.string() << "\n";
+
+        const auto requests{ParseFile(filepath)};
+        if (!requests) {
+          result << "Unable to read: " << filepath.string() << "\n";
+          return false;
+        }
+
+        if (requests->empty()) {
+          result << "No request to schedule.\n";
+          return true;
+        }
+
+        RunSchedulers(*requests, options, result);
+        return true;
+      },
+      output)};
+
+  if (failures > 0) {
+    std::cerr << failures << " of " << inputs.size() << " inputs failed" << std::endl;
+  }
+
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void PrintMetrics(std::ostream& output, const std::string& name, const ds::DiskMetricsSink& metrics,
+                  const Options& options) {
+  const auto average{metrics.Average()};
+
+  output << std::setprecision(1) << std::fixed << name << " " << metrics.seek << " "
+         << average.seek << " " << average.lt << " " << average.wt << std::endl;
+
+  for (const double percentile : options.percentiles) {
+    std::ostringstream label_stream{};
+    label_stream << "p" << percentile;
+
+    output << "  " << label_stream.str() << " "
+           << metrics.histograms.seek.Percentile(percentile) << " "
+           << metrics.histograms.lt.Percentile(percentile) << " "
+           << metrics.histograms.wt.Percentile(percentile) << std::endl;
+  }
+}
+
+// Reads the value of a "--name=value" argument.
+template <typename T>
+bool ParseValue(const std::string& argument, T& value) {
+  std::stringstream value_stream{argument.substr(argument.find('=') + 1)};
+  return static_cast<bool>(value_stream >> value) && value_stream.eof();
+}
+
+std::optional<Options> ParseOptions(int argc, char** argv) {
+  Options options{};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string argument{argv[i]};
+
+    if (argument.rfind("--percentiles=", 0) == 0) {
+      options.percentiles.clear();
+
+      std::stringstream list_stream{argument.substr(argument.find('=') + 1)};
+      std::string token{};
+
+      while (std::getline(list_stream, token, ',')) {
+        std::stringstream token_stream{token};
+
+        double percentile{};
+        if (!(token_stream >> percentile) || percentile < 0.0 || percentile > 100.0) {
+          std::cerr << "Bad percentile: " << token << std::endl;
+          return std::nullopt;
+        }
+
+        options.percentiles.push_back(percentile);
+      }
+    } else if (argument.rfind("--head=", 0) == 0) {
+      if (!ParseValue(argument, options.head)) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--cylinders=", 0) == 0) {
+      if (!ParseValue(argument, options.last_position) || options.last_position == 0) {
+        return std::nullopt;
+      }
+
+      options.last_position--;
+    } else if (argument.rfind("--expire=", 0) == 0) {
+      if (!ParseValue(argument, options.expire) || options.expire < 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--settle=", 0) == 0) {
+      if (!ParseValue(argument, options.model.settle) || options.model.settle < 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--seek-rate=", 0) == 0) {
+      if (!ParseValue(argument, options.model.seek_rate) || options.model.seek_rate == 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--transfer=", 0) == 0) {
+      if (!ParseValue(argument, options.model.transfer) || options.model.transfer < 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--threads=", 0) == 0) {
+      if (!ParseValue(argument, options.threads)) {
+        return std::nullopt;
+      }
+    } else if (argument == "--batch") {
+      options.batch = true;
+    } else if (argument.rfind("--output=", 0) == 0) {
+      options.output_filepath = argument.substr(argument.find('=') + 1);
+    } else if (argument.rfind("--", 0) == 0) {
+      return std::nullopt;
+    } else if (options.filepath.empty()) {
+      options.filepath = argument;
+      options.batch_inputs.push_back(argument);
+    } else if (options.batch) {
+      options.batch_inputs.push_back(argument);
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (options.filepath.empty()) {
+    return std::nullopt;
+  }
+
+  return options;
+}
+
+// One request per line: arrival time, cylinder or LBA and, optionally, size
+// (1 by default). Empty lines and lines starting with '#' are skipped.
+std::optional<std::vector<ds::Request>> ParseFile(const std::filesystem::path& filepath) {
+  std::ifstream file_stream{filepath, std::ios::in};
+  if (!file_stream) {
+    return std::nullopt;
+  }
+
+  std::vector<ds::Request> result{};
+  std::string line{};
+
+  while (std::getline(file_stream, line)) {
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+
+    std::stringstream line_stream{line};
+
+    ds::Time at{};
+    ds::Position position{};
+    std::uint32_t size{1};
+
+    if (!(line_stream >> at >> position) || at < 0) {
+      std::cerr << "Bad formatted input: " << line << std::endl;
+      continue;
+    }
+
+    if (!(line_stream >> std::ws).eof() && !(line_stream >> size)) {
+      std::cerr << "Bad formatted input: " << line << std::endl;
+      continue;
+    }
+
+    result.push_back({.at = at, .position = position, .size = size, .id = result.size()});
+  }
+
+  return result;
+}
@@ -7,10 +7,14 @@
 #include <optional>
 #include <queue>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "../common/batch.h"
+#include "../common/perf_counters.h"
+
 using page = unsigned int;
 using page_fault = unsigned int;
 using page_distance = std::size_t;
@@ -21,6 +25,7 @@ std::optional<virtual_memory> parse_input(const std::string &filepath);
 page_fault fifo(frame_capacity capacity, const std::vector<page> &references);
 page_fault otm(frame_capacity capacity, const std::vector<page> &references);
 page_fault lru(frame_capacity capacity, const std::vector<page> &references);
+int run_batch(const std::vector<std::string> &arguments);
 
 constexpr auto kPageDistanceComparer = [](const std::pair<page, page_distance> &lhs,
                                           const std::pair<page, page_distance> &rhs) {
@@ -29,12 +34,18 @@ constexpr auto kPageDistanceComparer = [](const std::pair<page, page_distance> &
 
 int main(int argc, const char **argv) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <file>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <file> [--profile]\n"
+              << "       " << argv[0] << " --batch <files, directories or globs...> [--output=file]"
+              << std::endl;
     std::cin.get();
 
     return EXIT_FAILURE;
   }
 
+  if (std::string{argv[1]} == "--batch") {
+    return run_batch({argv + 2, argv + argc});
+  }
+
   const auto parse_result = parse_input(argv[1]);
   if (!parse_result) {
     std::cerr << "Parsing failed!\n" << std::endl;
@@ -47,9 +58,39 @@ int main(int argc, const char **argv) {
   const auto frame_capacity = std::get<0>(virtual_memory);
   const auto &page_references = std::get<1>(virtual_memory);
 
-  std::cout << "FIFO " << fifo(frame_capacity, page_references) << "\n";
-  std::cout << "OTM " << otm(frame_capacity, page_references) << "\n";
-  std::cout << "LRU " << lru(frame_capacity, page_references) << std::endl;
+  // Hardware counters around every policy call, printed per page reference.
+  std::optional<perf::Counters> counters{};
+  if (argc > 2 && std::string{argv[2]} == "--profile") {
+    counters.emplace();
+
+    if (!counters->available()) {
+      std::cerr << "Hardware counters unavailable: " << counters->error() << std::endl;
+      counters.reset();
+    }
+  }
+
+  const auto report = [&](const std::string &name, auto policy) {
+    if (counters) {
+      counters->Start();
+    }
+
+    const page_fault faults{policy(frame_capacity, page_references)};
+    const auto sample{counters ? counters->Stop() : perf::Sample{}};
+
+    std::cout << name << " " << faults << "\n";
+
+    if (counters) {
+      std::cout << "  ";
+      perf::Print(std::cout, sample, page_references.size(), "reference");
+      std::cout << "\n";
+    }
+  };
+
+  report("FIFO", fifo);
+  report("OTM", otm);
+  report("LRU", lru);
+
+  std::cout << std::flush;
 
   std::cin.get();
 
@@ -144,6 +185,52 @@ page_fault lru(frame_capacity capacity, const std::vector<page> &references) {
   return faults;
 }
 
+// Every input on a thread pool, without interaction, into one ordered output.
+int run_batch(const std::vector<std::string> &arguments) {
+  std::vector<std::string> patterns{};
+  std::ofstream output_stream{};
+
+  for (const auto &argument : arguments) {
+    if (argument.rfind("--output=", 0) == 0) {
+      output_stream.open(argument.substr(argument.find('=') + 1), std::ios::out | std::ios::trunc);
+
+      if (!output_stream) {
+        std::cerr << "[UNABLE TO WRITE] \"" + argument.substr(argument.find('=') + 1) + "\""
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else {
+      patterns.push_back(argument);
+    }
+  }
+
+  const auto inputs{batch::ExpandInputs(patterns)};
+  const std::size_t thread_count{std::max(std::thread::hardware_concurrency(), 1U)};
+
+  const auto failures{batch::Run(
+      inputs, thread_count, 2 * thread_count,
+      [](const std::filesystem::path &filepath, std::ostream &result) {
+        result << "== " << filepath.string() << "\n";
+
+        const auto parse_result = parse_input(filepath.string());
+        if (!parse_result) {
+          result << "Parsing failed!\n";
+          return false;
+        }
+
+        const auto &[frame_capacity, page_references] = parse_result.value();
+
+        result << "FIFO " << fifo(frame_capacity, page_references) << "\n";
+        result << "OTM " << otm(frame_capacity, page_references) << "\n";
+        result << "LRU " << lru(frame_capacity, page_references) << "\n";
+
+        return true;
+      },
+      output_stream.is_open() ? static_cast<std::ostream &>(output_stream) : std::cout)};
+
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 std::optional<virtual_memory> parse_input(const std::string &filepath) {
   if (!std::filesystem::exists(filepath)) {
     std::cerr << "[FILE NOT FOUND] \"" + filepath + "\"" << std::endl;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ps {
+// What a scheduler with a bounded ready queue does with an arrival that finds
+// the queue full.
+enum class Admission : std::uint32_t {
+  kReject,      // The arrival is dropped
+  kDropOldest,  // The queued process that arrived first is dropped to make room
+  kDelay,       // The arrival waits outside the queue until there is room
+};
+
+// Ready queue bound. A preempted process always goes back to the queue, so its
+// place is kept while it runs and arrivals meanwhile see one slot less.
+struct QueueLimit {
+  std::size_t capacity;  // Unbounded if 0
+  Admission admission;
+};
+
+// How a run coped with the bound: dropped processes never complete, and the
+// work they had received is lost.
+struct OverloadMetrics {
+  std::size_t dropped;
+  float drop_rate;  // Dropped / all processes
+  float goodput;    // Burst time of the completed processes per time unit
+};
+}  // namespace ps
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ps {
+// Memory for repeated runs on one thread. Each run bumps a pointer through one
+// buffer that is kept from run to run and only grows, so once it has grown to
+// the largest run, runs make no global allocation at all, and whatever a run
+// allocated is released in one shot when the next one begins. A run that
+// outgrows its estimate falls back to the global heap instead of failing.
+//
+//   RunArena arena{};
+//   for (const auto& workload : workloads) {
+//     const auto allocator{arena.Begin(ArenaScheduler<SJFPolicy, HeapQueue>::ArenaBytes(n))};
+//     ArenaScheduler<SJFPolicy, HeapQueue> scheduler{workload, {}, allocator};
+//     scheduler.Start();
+//   }
+//
+// Everything allocated from the arena must be gone before the next Begin.
+//
+// The bump and the allocator below are inline and non-virtual: through a
+// std::pmr::monotonic_buffer_resource and polymorphic_allocator, every
+// allocation was a virtual call and every element was built by uses-allocator
+// construction, which made arena runs slower than the global heap ones.
+template <typename T>
+class ArenaAllocator;
+
+class RunArena {
+ public:
+  RunArena() = default;
+  RunArena(const RunArena&) = delete;
+  RunArena& operator=(const RunArena&) = delete;
+
+  // Starts a run of about `bytes`, releasing everything earlier runs took.
+  ArenaAllocator<std::byte> Begin(std::size_t bytes);
+
+  // Aligned to `alignment`, at most alignof(std::max_align_t).
+  void* Allocate(std::size_t bytes, std::size_t alignment) {
+    const auto address{reinterpret_cast<std::uintptr_t>(next_)};
+    const auto padding{(alignment - address % alignment) % alignment};
+
+    if (padding + bytes > static_cast<std::size_t>(end_ - next_)) {
+      return Overflow(bytes);
+    }
+
+    void* result{next_ + padding};
+    next_ += padding + bytes;
+
+    return result;
+  }
+
+ private:
+  // Kept until the next Begin.
+  void* Overflow(std::size_t bytes) {
+    return overflow_.emplace_back(std::make_unique_for_overwrite<std::byte[]>(bytes)).get();
+  }
+
+  std::unique_ptr<std::byte[]> buffer_{};
+  std::size_t capacity_{};
+  std::byte* next_{};
+  std::byte* end_{};
+  std::vector<std::unique_ptr<std::byte[]>> overflow_{};
+};
+
+// Standard allocator over a RunArena, for the Allocator of BasicScheduler
+// (ArenaScheduler). Deallocation is a no-op: memory comes back at Begin.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= alignof(std::max_align_t));
+
+  constexpr explicit ArenaAllocator(RunArena& arena) : arena_{&arena} {}
+
+  template <typename U>
+  constexpr ArenaAllocator(const ArenaAllocator<U>& other) : arena_{other.arena()} {}
+
+  T* allocate(std::size_t count) {
+    return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  constexpr void deallocate(T*, std::size_t) {}
+
+  constexpr RunArena* arena() const { return arena_; }
+
+  template <typename U>
+  constexpr bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+
+ private:
+  RunArena* arena_;
+};
+
+inline ArenaAllocator<std::byte> RunArena::Begin(std::size_t bytes) {
+  overflow_.clear();
+
+  if (bytes > capacity_) {
+    capacity_ = std::max(bytes, capacity_ * 2);
+    buffer_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+  }
+
+  next_ = buffer_.get();
+  end_ = next_ + capacity_;
+
+  return ArenaAllocator<std::byte>{*this};
+}
+}  // namespace ps
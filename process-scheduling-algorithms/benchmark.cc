@@ -0,0 +1,359 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "coroutine_process.h"
+#include "metrics_pass.h"
+#include "mpsc_queue.h"
+#include "online_scheduler.h"
+#include "scheduler.h"
+#include "workload.h"
+
+namespace {
+// Global heap allocations so far, counted by the operator new below.
+std::atomic<std::uint64_t> allocation_count{};
+
+std::vector<ps::GeneratedProcess> MakeWorkload(const benchmark::State& state) {
+  ps::WorkloadGenerator generator{{.mean_gap = static_cast<double>(state.range(1)),
+                                   .bursts = static_cast<ps::BurstDistribution>(state.range(2))}};
+
+  const auto workload{generator.Take(static_cast<std::size_t>(state.range(0)))};
+  return {workload.begin(), workload.end()};
+}
+
+template <typename Scheduler>
+void ReportCounters(benchmark::State& state, const Scheduler& scheduler,
+                    std::uint64_t allocations_before) {
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(allocation_count - allocations_before), benchmark::Counter::kAvgIterations);
+
+  // Built with -DPS_ENABLE_COUNTERS: per-run averages of the last iteration.
+  if constexpr (ps::DefaultCounters::kEnabled) {
+    const auto& counters{scheduler.counters()};
+
+    state.counters["events"] = static_cast<double>(counters.events);
+    state.counters["pushes"] = static_cast<double>(counters.pushes);
+    state.counters["pops"] = static_cast<double>(counters.pops);
+    state.counters["comparisons"] = static_cast<double>(counters.comparisons);
+    state.counters["idle_ticks"] = static_cast<double>(counters.idle_ticks);
+    state.counters["rescans"] = static_cast<double>(counters.rescans);
+  }
+}
+
+template <typename Scheduler, typename... SchedulerArgs>
+void RunScheduler(benchmark::State& state, SchedulerArgs... scheduler_args) {
+  const auto processes{MakeWorkload(state)};
+  std::optional<Scheduler> scheduler{};
+
+  const auto allocations_before{allocation_count.load()};
+
+  for (auto _ : state) {
+    scheduler.emplace(processes, scheduler_args...);
+    benchmark::DoNotOptimize(scheduler->Start());
+  }
+
+  ReportCounters(state, *scheduler, allocations_before);
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+// The same runs with the process table and the ready queue in an arena that
+// every iteration reuses, so they make no global allocation.
+template <typename Scheduler, typename Policy>
+void RunSchedulerInArena(benchmark::State& state, Policy policy) {
+  const auto processes{MakeWorkload(state)};
+  ps::RunArena arena{};
+  std::optional<Scheduler> scheduler{};
+
+  const auto allocations_before{allocation_count.load()};
+
+  for (auto _ : state) {
+    scheduler.reset();
+    scheduler.emplace(processes, policy, arena.Begin(Scheduler::ArenaBytes(processes.size())));
+    benchmark::DoNotOptimize(scheduler->Start());
+  }
+
+  ReportCounters(state, *scheduler, allocations_before);
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_FCFS(benchmark::State& state) { RunScheduler<ps::FCFSScheduler>(state); }
+
+void BM_SJF(benchmark::State& state) { RunScheduler<ps::SJFScheduler>(state); }
+
+void BM_RR(benchmark::State& state) {
+  RunScheduler<ps::RRScheduler>(state, static_cast<int>(state.range(3)));
+}
+
+void BM_FCFSArena(benchmark::State& state) {
+  RunSchedulerInArena<ps::ArenaScheduler<ps::FCFSPolicy, ps::FifoQueue>>(state, ps::FCFSPolicy{});
+}
+
+void BM_SJFArena(benchmark::State& state) {
+  RunSchedulerInArena<ps::ArenaScheduler<ps::SJFPolicy, ps::HeapQueue>>(state, ps::SJFPolicy{});
+}
+
+void BM_RRArena(benchmark::State& state) {
+  RunSchedulerInArena<ps::ArenaScheduler<ps::RRPolicy, ps::FifoQueue>>(
+      state, ps::RRPolicy{static_cast<int>(state.range(3))});
+}
+
+// The metrics pass alone over the process table of a completed RR run, with
+// or without histograms. Bytes are those of the table it reads.
+void BM_MetricsPass(benchmark::State& state) {
+  ps::WorkloadGenerator generator{{.mean_gap = 8.0}};
+  const auto workload{generator.Take(static_cast<std::size_t>(state.range(0)))};
+  const std::vector<ps::GeneratedProcess> processes(workload.begin(), workload.end());
+
+  ps::BasicScheduler<ps::RRPolicy, ps::FifoQueue, int, ps::AverageMetricsSink> scheduler{
+      processes, ps::RRPolicy{2}};
+  scheduler.Start();
+
+  auto histograms{std::make_unique<ps::ProcessHistograms>()};
+  auto table{scheduler.processes()};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ps::SummarizeTable(table, state.range(1) != 0 ? histograms.get() : nullptr));
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0) *
+                          static_cast<std::int64_t>(sizeof(ps::Process)));
+}
+
+void BM_SJFColumnar(benchmark::State& state) {
+  RunScheduler<ps::BasicScheduler<ps::SJFPolicy, ps::HeapQueue, int, ps::ColumnarMetricsSink>>(
+      state);
+}
+
+// Streams generated processes into an online scheduler, advancing the clock
+// to every arrival, so memory stays bounded by the live processes.
+template <typename Scheduler>
+void StreamScheduler(benchmark::State& state, Scheduler prototype) {
+  const auto count{static_cast<std::size_t>(state.range(0))};
+
+  for (auto _ : state) {
+    ps::WorkloadGenerator generator{{.mean_gap = static_cast<double>(state.range(1)),
+                                     .bursts = static_cast<ps::BurstDistribution>(state.range(2))}};
+    Scheduler scheduler{prototype};
+
+    for (std::size_t i = 0; i < count; i++) {
+      const auto process{generator.Next()};
+
+      scheduler.AdvanceTo(process.at);
+      scheduler.Submit(process);
+    }
+
+    scheduler.Drain();
+    benchmark::DoNotOptimize(scheduler.Snapshot());
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_OnlineSJF(benchmark::State& state) { StreamScheduler(state, ps::OnlineSJFScheduler{}); }
+
+void BM_OnlineRR(benchmark::State& state) {
+  StreamScheduler(state, ps::OnlineRRScheduler{static_cast<int>(state.range(3))});
+}
+
+// `state.range(0)` producer threads push arrivals into a ring that the
+// benchmark thread drains, in batches, into an online FCFS scheduler.
+void BM_MpscIngest(benchmark::State& state) {
+  constexpr std::size_t kProcessesPerRun{1 << 16};
+  constexpr std::size_t kBatchSize{256};
+
+  const auto producer_count{static_cast<std::size_t>(state.range(0))};
+  const auto processes_per_producer{kProcessesPerRun / producer_count};
+
+  for (auto _ : state) {
+    ps::MpscQueue<ps::Process> arrivals{4096};
+    ps::OnlineScheduler<ps::FCFSPolicy, ps::FifoQueue, int, ps::AverageMetricsSink> scheduler{};
+
+    std::vector<std::thread> producers{};
+    for (std::size_t producer = 0; producer < producer_count; producer++) {
+      producers.emplace_back([&arrivals, producer, processes_per_producer] {
+        for (std::size_t i = 0; i < processes_per_producer; i++) {
+          const ps::Process process{.at = static_cast<int>(i), .bt = 1,
+                                    .id = producer * processes_per_producer + i};
+
+          while (!arrivals.TryPush(process)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    std::size_t received{};
+    while (received < processes_per_producer * producer_count) {
+      const auto drained{arrivals.Drain([&](const ps::Process& process) { scheduler.Submit(process); },
+                                        kBatchSize)};
+      if (drained == 0) {
+        std::this_thread::yield();
+      }
+
+      received += drained;
+    }
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+
+    scheduler.Drain();
+    benchmark::DoNotOptimize(scheduler.Snapshot());
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kProcessesPerRun));
+}
+
+ps::ProcessTask LockingWorker(ps::SimulatedLock& lock, int iterations, int io) {
+  for (int i = 0; i < iterations; i++) {
+    co_await ps::Cpu(3);
+    co_await ps::Acquire(lock);
+    co_await ps::Cpu(1);
+    co_await ps::Release(lock);
+    co_await ps::Io(io);
+  }
+}
+
+// `state.range(0)` coroutine processes alternating CPU bursts, a shared lock
+// and I/O of `state.range(1)` on average (each process its own length, from 1
+// to twice that), under RR with quantum 2, with I/O completions in a Timers
+// queue.
+template <template <typename> class Timers>
+void BM_Coroutines(benchmark::State& state) {
+  constexpr int kIterations{32};
+  const auto count{static_cast<int>(state.range(0))};
+  const auto io{static_cast<int>(state.range(1))};
+
+  for (auto _ : state) {
+    ps::SimulatedLock lock{};
+    ps::CoroutineScheduler<ps::RRPolicy, ps::FifoQueue, int, ps::HistogramMetricsSink, Timers>
+        scheduler{ps::RRPolicy{2}};
+
+    for (int i = 0; i < count; i++) {
+      scheduler.Spawn(LockingWorker(lock, kIterations, 1 + (i * 7919) % (2 * io)), i);
+    }
+
+    benchmark::DoNotOptimize(scheduler.Run());
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * count * kIterations);
+}
+
+// `state.range(0)` pending timers, each rescheduled up to `state.range(1)`
+// ahead when it expires, as RR processes going back to I/O do.
+template <template <typename> class Timers>
+void BM_Timers(benchmark::State& state) {
+  const auto count{static_cast<std::size_t>(state.range(0))};
+  const auto horizon{static_cast<std::uint32_t>(state.range(1))};
+  constexpr std::size_t kExpiries{1 << 16};
+
+  for (auto _ : state) {
+    Timers<std::int64_t> timers{};
+    timers.Reserve(count);
+
+    std::uint32_t random{12345};
+    const auto delay = [&random, horizon] {
+      random = random * 1664525 + 1013904223;
+      return 1 + static_cast<std::int64_t>((random >> 8) % horizon);
+    };
+
+    for (std::size_t i = 0; i < count; i++) {
+      timers.Schedule(delay(), i);
+    }
+
+    std::size_t expired{};
+    while (expired < kExpiries) {
+      const auto now{timers.NextDue()};
+      timers.Expire(now, [&](std::size_t index) {
+        timers.Schedule(now + delay(), index);
+        expired++;
+      });
+    }
+
+    benchmark::DoNotOptimize(expired);
+  }
+
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kExpiries));
+}
+
+// n x mean arrival gap x burst distribution (x quantum, for RR).
+void WorkloadArguments(benchmark::internal::Benchmark* benchmark,
+                       const std::vector<std::int64_t>& quanta) {
+  for (const std::int64_t count : {64, 512, 4096}) {
+    for (const std::int64_t mean_gap : {0, 8, 16}) {
+      for (const auto distribution : {ps::BurstDistribution::kExponential,
+                                      ps::BurstDistribution::kPareto,
+                                      ps::BurstDistribution::kBimodal}) {
+        const auto distribution_arg{static_cast<std::int64_t>(distribution)};
+
+        if (quanta.empty()) {
+          benchmark->Args({count, mean_gap, distribution_arg});
+        }
+
+        for (const std::int64_t quantum : quanta) {
+          benchmark->Args({count, mean_gap, distribution_arg, quantum});
+        }
+      }
+    }
+  }
+}
+
+void PolicyArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"n", "gap", "burst"});
+  WorkloadArguments(benchmark, {});
+}
+
+void RRArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"n", "gap", "burst", "quantum"});
+  WorkloadArguments(benchmark, {2, 8});
+}
+}  // namespace
+
+BENCHMARK(BM_FCFS)->Apply(PolicyArguments);
+BENCHMARK(BM_SJF)->Apply(PolicyArguments);
+BENCHMARK(BM_RR)->Apply(RRArguments);
+BENCHMARK(BM_SJFColumnar)->Apply(PolicyArguments);
+BENCHMARK(BM_MetricsPass)
+    ->ArgNames({"n", "histograms"})
+    ->ArgsProduct({{1 << 12, 1 << 16, 1 << 22}, {0, 1}});
+BENCHMARK(BM_FCFSArena)->Apply(PolicyArguments);
+BENCHMARK(BM_SJFArena)->Apply(PolicyArguments);
+BENCHMARK(BM_RRArena)->Apply(RRArguments);
+BENCHMARK(BM_OnlineSJF)->Apply(PolicyArguments);
+BENCHMARK(BM_OnlineRR)->Apply(RRArguments);
+BENCHMARK(BM_Coroutines<ps::TimerHeap>)->ArgNames({"n", "io"})->ArgsProduct({{64, 512, 4096}, {1, 1000}});
+BENCHMARK(BM_Coroutines<ps::TimingWheel>)->ArgNames({"n", "io"})->ArgsProduct({{64, 512, 4096}, {1, 1000}});
+BENCHMARK(BM_Timers<ps::TimerHeap>)
+    ->ArgNames({"n", "horizon"})
+    ->ArgsProduct({{64, 4096, 1 << 18}, {64, 1 << 20}});
+BENCHMARK(BM_Timers<ps::TimingWheel>)
+    ->ArgNames({"n", "horizon"})
+    ->ArgsProduct({{64, 4096, 1 << 18}, {64, 1 << 20}});
+BENCHMARK(BM_MpscIngest)->ArgName("producers")->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+// Counts every global allocation (allocs, per iteration, in the results).
+[[gnu::noinline]] void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+  if (void* pointer{std::malloc(size > 0 ? size : 1)}) {
+    return pointer;
+  }
+
+  throw std::bad_alloc{};
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+[[gnu::noinline]] void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+BENCHMARK_MAIN();
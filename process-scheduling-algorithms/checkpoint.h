@@ -0,0 +1,450 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "scheduler.h"
+#include "workload_hash.h"
+
+namespace ps {
+// Each checkpoint slot file has a fixed layout, so it can be updated in place:
+//
+//   header      CheckpointHeader
+//   policy      the policy object (RR quantum)
+//   sink        accumulated metrics, histograms included
+//   counters    SchedulerCounters, if enabled
+//   processes   the whole process table, results and remaining bursts included
+//   queue       room for one index per process; the first queue_size are the
+//               ready queue, as given by the queue's segments()
+struct CheckpointHeader {
+  static constexpr std::array<char, 8> kMagic{'P', 'S', 'C', 'H', 'E', 'C', 'K', 'P'};
+  static constexpr std::uint32_t kVersion = 2;
+
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t complete;  // 0 while the slot is being written
+  std::uint64_t sequence;  // The newest complete slot wins
+  std::uint32_t time_size;
+  std::uint32_t process_size;
+  std::uint64_t policy_size;
+  std::uint64_t sink_size;
+  std::uint64_t counters_size;
+  std::uint64_t process_count;
+  std::uint64_t workload_hash;
+  std::uint64_t queue_size;
+  std::uint64_t next_arrival;
+  std::uint64_t finished_count;
+  std::int64_t clock;
+  std::uint64_t queue_capacity;  // QueueLimit
+  std::uint64_t admission;
+};
+
+// Saves and resumes a BasicScheduler between two Steps.
+//
+// Checkpoints alternate between two slot files (`filepath`.0 and .1), so a run
+// killed while saving still has the other, complete one. A slot is written in
+// full only the first time; afterwards only what changed since that slot was
+// last saved is rewritten: the processes that were in the ready queue then and
+// those admitted since. Everything else in the table has either completed or
+// not arrived yet, and is already on disk. Each part is written straight from
+// the scheduler's memory with pwritev(2), with no serialization buffer, so the
+// cost of a checkpoint follows the live processes, not the workload size.
+//
+//   Checkpointer checkpointer{scheduler, "run.checkpoint"};
+//   checkpointer.Load();  // Begins, then resumes if a checkpoint matches
+//   while (scheduler.Step(interval)) {
+//     checkpointer.Save();
+//   }
+//   checkpointer.Remove();
+//
+// A checkpoint only resumes the workload it was taken from (same arrivals,
+// bursts and ids), with the same scheduler type, policy and queue limit.
+template <typename Scheduler>
+class Checkpointer {
+ public:
+  Checkpointer(Scheduler& scheduler, std::filesystem::path filepath)
+      : scheduler_{scheduler}, filepath_{std::move(filepath)} {}
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  ~Checkpointer() {
+    for (auto& slot : slots_) {
+      if (slot.descriptor >= 0) {
+        close(slot.descriptor);
+      }
+    }
+  }
+
+  // Begins the scheduler and restores it from the newest complete slot that
+  // belongs to it. Returns false, leaving the scheduler as Begin left it, if
+  // there is none.
+  bool Load() {
+    scheduler_.Begin();
+    workload_hash_ = WorkloadHash();
+
+    std::optional<std::size_t> newest{};
+    std::array<CheckpointHeader, 2> headers{};
+
+    for (std::size_t i = 0; i < slots_.size(); i++) {
+      const int descriptor{open(SlotPath(i).c_str(), O_RDONLY)};
+      if (descriptor < 0) {
+        continue;
+      }
+
+      if (ReadAt(descriptor, &headers[i], sizeof(CheckpointHeader), 0) && Matches(headers[i]) &&
+          (!newest || headers[i].sequence > headers[*newest].sequence)) {
+        newest = i;
+      }
+
+      close(descriptor);
+    }
+
+    if (!newest) {
+      return false;
+    }
+
+    if (!Restore(*newest, headers[*newest])) {
+      scheduler_.Begin();
+      return false;
+    }
+
+    sequence_ = headers[*newest].sequence;
+    return true;
+  }
+
+  // Saves the scheduler as it is between two Steps.
+  bool Save() {
+    if (workload_hash_ == 0) {
+      workload_hash_ = WorkloadHash();
+    }
+
+    auto& slot{slots_[(sequence_ + 1) % slots_.size()]};
+
+    if (slot.descriptor < 0) {
+      const auto path{SlotPath(static_cast<std::size_t>(&slot - slots_.data()))};
+
+      slot.descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      slot.synced = false;
+
+      if (slot.descriptor < 0) {
+        return false;
+      }
+    }
+
+    auto header{MakeHeader()};
+    header.sequence = sequence_ + 1;
+
+    // The slot is invalid until everything below is on disk.
+    if (!WriteAt(slot.descriptor, {{&header, sizeof(header)}}, 0) ||
+        fdatasync(slot.descriptor) != 0 || !WriteState(slot, header) ||
+        fdatasync(slot.descriptor) != 0) {
+      slot.synced = false;
+      return false;
+    }
+
+    header.complete = 1;
+
+    if (!WriteAt(slot.descriptor, {{&header, sizeof(header)}}, 0) ||
+        fdatasync(slot.descriptor) != 0) {
+      slot.synced = false;
+      return false;
+    }
+
+    RememberQueue(slot);
+    sequence_++;
+
+    return true;
+  }
+
+  // Deletes both slots, once the run has completed.
+  void Remove() {
+    for (std::size_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].descriptor >= 0) {
+        close(slots_[i].descriptor);
+        slots_[i].descriptor = -1;
+      }
+
+      std::filesystem::remove(SlotPath(i));
+    }
+  }
+
+ private:
+  struct Slot {
+    int descriptor{-1};
+    bool synced{};                    // The file holds the state described below
+    std::vector<std::size_t> queued;  // Ready queue when the slot was last saved
+    std::size_t next_arrival{};       // First process not admitted then
+  };
+
+  std::filesystem::path SlotPath(std::size_t slot) const {
+    auto path{filepath_};
+    path += "." + std::to_string(slot);
+    return path;
+  }
+
+  CheckpointHeader MakeHeader() const {
+    const auto segments{scheduler_.queue_.segments()};
+
+    return {.magic = CheckpointHeader::kMagic,
+            .version = CheckpointHeader::kVersion,
+            .time_size = sizeof(scheduler_.clock_),
+            .process_size = sizeof(typename Scheduler::ProcessType),
+            .policy_size = sizeof(scheduler_.policy_),
+            .sink_size = sizeof(scheduler_.sink_),
+            .counters_size = kCountersSize,
+            .process_count = scheduler_.processes_.size(),
+            .workload_hash = workload_hash_,
+            .queue_size = segments[0].size() + segments[1].size(),
+            .next_arrival = scheduler_.next_arrival_,
+            .finished_count = scheduler_.finished_count_,
+            .clock = static_cast<std::int64_t>(scheduler_.clock_),
+            .queue_capacity = scheduler_.limit_.capacity,
+            .admission = static_cast<std::uint64_t>(scheduler_.limit_.admission)};
+  }
+
+  bool Matches(const CheckpointHeader& header) const {
+    auto expected{MakeHeader()};
+
+    return header.magic == expected.magic && header.version == expected.version &&
+           header.complete == 1 && header.time_size == expected.time_size &&
+           header.process_size == expected.process_size &&
+           header.policy_size == expected.policy_size && header.sink_size == expected.sink_size &&
+           header.counters_size == expected.counters_size &&
+           header.process_count == expected.process_count &&
+           header.workload_hash == expected.workload_hash &&
+           header.queue_capacity == expected.queue_capacity &&
+           header.admission == expected.admission &&
+           header.queue_size <= header.process_count &&
+           header.next_arrival <= header.process_count &&
+           header.finished_count <= header.process_count;
+  }
+
+  // Writes every part that may differ from what the slot holds: all of them
+  // the first time, then the changed processes only.
+  bool WriteState(Slot& slot, const CheckpointHeader& header) {
+    const auto* table{scheduler_.processes_.data()};
+    const auto segments{scheduler_.queue_.segments()};
+
+    if (!WriteAt(slot.descriptor,
+                 {{&scheduler_.policy_, kPolicySize},
+                  {&scheduler_.sink_, kSinkSize},
+                  {&scheduler_.counters_, kCountersSize}},
+                 sizeof(CheckpointHeader)) ||
+        !WriteAt(slot.descriptor,
+                 {{segments[0].data(), segments[0].size_bytes()},
+                  {segments[1].data(), segments[1].size_bytes()}},
+                 QueueOffset())) {
+      return false;
+    }
+
+    if (!slot.synced) {
+      return WriteRecords(slot.descriptor, table, 0, header.process_count);
+    }
+
+    // Queued indexes are sorted and all below the previous next_arrival, so
+    // adjacent ones are written as one run, and so are the processes admitted
+    // since.
+    for (std::size_t first = 0; first < slot.queued.size();) {
+      auto last{first + 1};
+      while (last < slot.queued.size() && slot.queued[last] == slot.queued[last - 1] + 1) {
+        last++;
+      }
+
+      if (!WriteRecords(slot.descriptor, table, slot.queued[first], slot.queued[last - 1] + 1)) {
+        return false;
+      }
+
+      first = last;
+    }
+
+    return WriteRecords(slot.descriptor, table, slot.next_arrival, header.next_arrival);
+  }
+
+  bool WriteRecords(int descriptor, const typename Scheduler::ProcessType* table,
+                    std::size_t first, std::size_t last) const {
+    if (first >= last) {
+      return true;
+    }
+
+    return WriteAt(descriptor, {{table + first, (last - first) * kProcessSize}},
+                   TableOffset() + first * kProcessSize);
+  }
+
+  void RememberQueue(Slot& slot) {
+    const auto segments{scheduler_.queue_.segments()};
+
+    slot.queued.assign(segments[0].begin(), segments[0].end());
+    slot.queued.insert(slot.queued.end(), segments[1].begin(), segments[1].end());
+    std::sort(slot.queued.begin(), slot.queued.end());
+
+    slot.next_arrival = scheduler_.next_arrival_;
+    slot.synced = true;
+  }
+
+  bool Restore(std::size_t slot_index, const CheckpointHeader& header) {
+    const int descriptor{open(SlotPath(slot_index).c_str(), O_RDONLY)};
+    if (descriptor < 0) {
+      return false;
+    }
+
+    // Policies with parameters (the RR quantum) must match.
+    auto policy{scheduler_.policy_};
+    std::vector<std::size_t> queue(header.queue_size);
+
+    bool restored{ReadAt(descriptor, &policy, kPolicySize, sizeof(CheckpointHeader))};
+
+    if constexpr (!std::is_empty_v<decltype(policy)>) {
+      restored = restored && std::memcmp(&policy, &scheduler_.policy_, kPolicySize) == 0;
+    }
+
+    restored = restored &&
+               ReadAt(descriptor, &scheduler_.sink_, kSinkSize,
+                      sizeof(CheckpointHeader) + kPolicySize) &&
+               ReadAt(descriptor, &scheduler_.counters_, kCountersSize,
+                      sizeof(CheckpointHeader) + kPolicySize + kSinkSize) &&
+               ReadAt(descriptor, scheduler_.processes_.data(),
+                      header.process_count * kProcessSize, TableOffset()) &&
+               ReadAt(descriptor, queue.data(), queue.size() * sizeof(std::size_t),
+                      QueueOffset()) &&
+               std::all_of(queue.begin(), queue.end(), [&](std::size_t index) {
+                 return index < header.process_count;
+               });
+
+    close(descriptor);
+
+    if (!restored) {
+      return false;
+    }
+
+    scheduler_.queue_.Assign(queue);
+    scheduler_.clock_ = static_cast<decltype(scheduler_.clock_)>(header.clock);
+    scheduler_.next_arrival_ = header.next_arrival;
+    scheduler_.finished_count_ = header.finished_count;
+
+    // The loaded slot now matches the scheduler; the next save goes to the
+    // other one, which is rewritten in full.
+    auto& slot{slots_[slot_index]};
+    slot.descriptor = open(SlotPath(slot_index).c_str(), O_RDWR);
+    RememberQueue(slot);
+    slot.synced = slot.descriptor >= 0;
+
+    return true;
+  }
+
+  // Never 0, which marks the hash as not computed yet.
+  std::uint64_t WorkloadHash() const { return HashWorkload(scheduler_.processes_) | 1; }
+
+  std::uint64_t TableOffset() const {
+    return sizeof(CheckpointHeader) + kPolicySize + kSinkSize + kCountersSize;
+  }
+
+  std::uint64_t QueueOffset() const {
+    return TableOffset() + scheduler_.processes_.size() * kProcessSize;
+  }
+
+  struct Part {
+    const void* data;
+    std::size_t size;
+  };
+
+  // pwritev until every byte is out, resuming after partial writes.
+  static bool WriteAt(int descriptor, std::initializer_list<Part> parts, std::uint64_t offset) {
+    std::array<iovec, 3> vectors{};
+    std::size_t count{};
+
+    for (const auto& part : parts) {
+      if (part.size > 0) {
+        vectors[count++] = {const_cast<void*>(part.data), part.size};
+      }
+    }
+
+    std::span<iovec> pending{vectors.data(), count};
+
+    while (!pending.empty()) {
+      auto written{pwritev(descriptor, pending.data(), static_cast<int>(pending.size()),
+                           static_cast<off_t>(offset))};
+
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        return false;
+      }
+
+      offset += static_cast<std::uint64_t>(written);
+
+      while (written > 0) {
+        auto& part{pending.front()};
+        const auto consumed{std::min(static_cast<std::size_t>(written), part.iov_len)};
+
+        part.iov_base = static_cast<char*>(part.iov_base) + consumed;
+        part.iov_len -= consumed;
+        written -= static_cast<ssize_t>(consumed);
+
+        if (part.iov_len == 0) {
+          pending = pending.subspan(1);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  static bool ReadAt(int descriptor, void* data, std::size_t size, std::uint64_t offset) {
+    auto* bytes{static_cast<char*>(data)};
+
+    while (size > 0) {
+      const auto count{pread(descriptor, bytes, size, static_cast<off_t>(offset))};
+
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+
+      if (count <= 0) {
+        return false;
+      }
+
+      bytes += count;
+      offset += static_cast<std::uint64_t>(count);
+      size -= static_cast<std::size_t>(count);
+    }
+
+    return true;
+  }
+
+  using CountersType = std::remove_cvref_t<decltype(std::declval<Scheduler&>().counters())>;
+
+  static constexpr std::size_t kProcessSize = sizeof(typename Scheduler::ProcessType);
+  static constexpr std::size_t kPolicySize = sizeof(Scheduler::policy_);
+  static constexpr std::size_t kSinkSize = sizeof(Scheduler::sink_);
+  static constexpr std::size_t kCountersSize = CountersType::kEnabled ? sizeof(CountersType) : 0;
+
+  static_assert(std::is_trivially_copyable_v<typename Scheduler::ProcessType> &&
+                std::is_trivially_copyable_v<decltype(Scheduler::sink_)> &&
+                std::is_trivially_copyable_v<decltype(Scheduler::policy_)>);
+
+  Scheduler& scheduler_;
+  const std::filesystem::path filepath_;
+
+  std::array<Slot, 2> slots_{};
+  std::uint64_t sequence_{};
+  std::uint64_t workload_hash_{};
+};
+}  // namespace ps
@@ -0,0 +1,483 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ready_queue.h"
+#include "scheduler.h"
+#include "timer_queue.h"
+
+namespace ps {
+// Coroutine frames are recycled through per-thread free lists, one per 64-byte
+// size class, so spawning and finishing processes does not go back to the heap
+// once a frame of the same size has been used.
+class FramePool {
+ public:
+  static void* Allocate(std::size_t size) {
+    const auto size_class{SizeClassOf(size)};
+    if (size_class >= kSizeClassCount) {
+      return ::operator new(size);
+    }
+
+    auto& free_list{Lists().heads[size_class]};
+    if (free_list) {
+      auto* block{free_list};
+      free_list = block->next;
+
+      return block;
+    }
+
+    return ::operator new((size_class + 1) * kGranularity);
+  }
+
+  static void Deallocate(void* frame, std::size_t size) {
+    const auto size_class{SizeClassOf(size)};
+    if (size_class >= kSizeClassCount) {
+      ::operator delete(frame);
+      return;
+    }
+
+    auto& free_list{Lists().heads[size_class]};
+    free_list = new (frame) FreeBlock{free_list};
+  }
+
+ private:
+  static constexpr std::size_t kGranularity = 64;
+  static constexpr std::size_t kSizeClassCount = 64;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct FreeLists {
+    ~FreeLists() {
+      for (auto* head : heads) {
+        while (head) {
+          ::operator delete(std::exchange(head, head->next));
+        }
+      }
+    }
+
+    std::array<FreeBlock*, kSizeClassCount> heads{};
+  };
+
+  static std::size_t SizeClassOf(std::size_t size) { return (size - 1) / kGranularity; }
+
+  static FreeLists& Lists() {
+    thread_local FreeLists lists{};
+    return lists;
+  }
+};
+
+// Mutex shared by simulated processes. Waiters are granted it in FIFO order.
+class SimulatedLock {
+ public:
+  bool held() const { return held_; }
+
+ private:
+  template <typename, template <typename> class, typename, typename, template <typename> class>
+  friend class CoroutineScheduler;
+
+  static constexpr std::size_t kNoTask = std::numeric_limits<std::size_t>::max();
+
+  bool held_{};
+  bool used_{};  // By the current run, which resets it when it ends
+  std::size_t first_waiter_{kNoTask};
+  std::size_t last_waiter_{kNoTask};
+};
+
+// What a process waits for at its current suspension point.
+struct ProcessRequest {
+  enum class Kind { kNone, kCpu, kIo, kAcquire, kRelease };
+
+  Kind kind;
+  std::int64_t amount;
+  SimulatedLock* lock;
+};
+
+// A simulated process written as a coroutine:
+//
+//   ps::ProcessTask Worker(ps::SimulatedLock& lock) {
+//     co_await ps::Cpu(4);
+//     co_await ps::Acquire(lock);
+//     co_await ps::Cpu(2);
+//     co_await ps::Release(lock);
+//     co_await ps::Io(10);
+//     co_await ps::Cpu(3);
+//   }
+class ProcessTask {
+ public:
+  struct promise_type {
+    static void* operator new(std::size_t size) { return FramePool::Allocate(size); }
+    static void operator delete(void* frame, std::size_t size) { FramePool::Deallocate(frame, size); }
+
+    ProcessTask get_return_object() {
+      return ProcessTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    void return_void() {}
+    void unhandled_exception() { throw; }
+
+    ProcessRequest request{};
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  ProcessTask(ProcessTask&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+
+  ProcessTask& operator=(ProcessTask&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+
+    return *this;
+  }
+
+  ~ProcessTask() { Destroy(); }
+
+  // Hands the coroutine over to the caller, who becomes responsible for it.
+  Handle Release() { return std::exchange(handle_, {}); }
+
+ private:
+  explicit ProcessTask(Handle handle) : handle_{handle} {}
+
+  void Destroy() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  Handle handle_{};
+};
+
+// Awaitable that suspends the process until the scheduler has handled `request`.
+struct ProcessAwaiter {
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(ProcessTask::Handle handle) const noexcept {
+    handle.promise().request = request;
+  }
+
+  void await_resume() const noexcept {}
+
+  ProcessRequest request;
+};
+
+// Needs `amount` units of CPU time (one burst).
+inline ProcessAwaiter Cpu(std::int64_t amount) {
+  return {{ProcessRequest::Kind::kCpu, amount, nullptr}};
+}
+
+// Blocks for `amount` units without using the CPU.
+inline ProcessAwaiter Io(std::int64_t amount) {
+  return {{ProcessRequest::Kind::kIo, amount, nullptr}};
+}
+
+inline ProcessAwaiter Acquire(SimulatedLock& lock) {
+  return {{ProcessRequest::Kind::kAcquire, 0, &lock}};
+}
+
+inline ProcessAwaiter Release(SimulatedLock& lock) {
+  return {{ProcessRequest::Kind::kRelease, 0, &lock}};
+}
+
+// Single CPU event loop over coroutine processes. Each CPU burst is queued
+// like a BasicScheduler process (at = when it became ready, bt = its length),
+// so the same policies and queues apply; SJF picks the shortest next burst.
+//
+// Metrics per process: tt from spawn to return, rt from spawn to the first
+// dispatch and wt as the time spent in the ready queue (I/O and lock waits are
+// in tt but not in wt). Handling a request allocates nothing once the
+// containers have grown to the number of processes.
+//
+// I/O completions wait in a Timers queue (see timer_queue.h): the TimerHeap by
+// default, or a TimingWheel, whose O(1) Schedule pays off when many processes
+// are in I/O at once. Both resume processes in the same order.
+template <typename Policy, template <typename> class Queue, typename Time = int,
+          typename Sink = HistogramMetricsSink, template <typename> class Timers = TimerHeap>
+class CoroutineScheduler {
+ public:
+  explicit CoroutineScheduler(Policy policy = {}) : policy_{policy} {}
+
+  CoroutineScheduler(const CoroutineScheduler&) = delete;
+  CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+
+  ~CoroutineScheduler() { Retire(); }
+
+  void Spawn(ProcessTask process, Time at) {
+    tasks_.push_back({.handle = process.Release(), .at = at});
+    bursts_.push_back({.at = at, .id = bursts_.size()});
+  }
+
+  // Runs every process spawned since the last Run to completion, from time 0.
+  // Processes still blocked on a lock when nothing else can happen are left
+  // unfinished. A run consumes its processes: the unfinished ones are
+  // destroyed and the locks they used are released, so a Run with no new
+  // Spawn runs nothing.
+  ProcessAverageMetrics Run() {
+    sink_.Reset();
+    clock_ = {};
+    ready_ = Queue<OrderType>{OrderType{&bursts_}};
+    ready_.Reserve(tasks_.size());
+    resumable_.Reserve(tasks_.size());
+    timers_.Reserve(tasks_.size());
+
+    std::vector<std::size_t> arrivals(tasks_.size());
+    for (std::size_t i = 0; i < arrivals.size(); i++) {
+      arrivals[i] = i;
+    }
+
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [this](std::size_t lhs, std::size_t rhs) { return tasks_[lhs].at < tasks_[rhs].at; });
+
+    std::size_t next_arrival{};
+    std::size_t running{kIdle};
+    Time slice_start{};
+    Time slice_end{};
+
+    while (true) {
+      std::size_t preempted{kIdle};
+
+      // Everything due now: arrivals, I/O completions and the running slice.
+      while (next_arrival < arrivals.size() && tasks_[arrivals[next_arrival]].at <= clock_) {
+        resumable_.Push(arrivals[next_arrival++]);
+      }
+
+      timers_.Expire(clock_, [this](std::size_t index) { resumable_.Push(index); });
+
+      if (running != kIdle && slice_end <= clock_) {
+        auto& burst{bursts_[running]};
+        burst.rbt -= slice_end - slice_start;
+
+        if (burst.rbt == 0) {
+          resumable_.Push(running);
+        } else {
+          preempted = running;
+        }
+
+        running = kIdle;
+      }
+
+      while (!resumable_.empty()) {
+        Resume(resumable_.Pop());
+      }
+
+      if (preempted != kIdle) {
+        MakeReady(preempted);
+      }
+
+      if (running == kIdle && !ready_.empty()) {
+        running = ready_.Pop();
+
+        auto& task{tasks_[running]};
+        auto& burst{bursts_[running]};
+
+        if (!task.dispatched) {
+          task.st = clock_;
+          task.dispatched = true;
+        }
+
+        task.waited += clock_ - task.ready_since;
+
+        slice_start = clock_;
+        slice_end = clock_ + policy_.Slice(burst.rbt);
+      }
+
+      auto next_event{std::numeric_limits<Time>::max()};
+
+      if (running != kIdle) {
+        next_event = std::min(next_event, slice_end);
+      }
+
+      if (!timers_.empty()) {
+        next_event = std::min(next_event, timers_.NextDue());
+      }
+
+      if (next_arrival < arrivals.size()) {
+        next_event = std::min(next_event, tasks_[arrivals[next_arrival]].at);
+      }
+
+      if (next_event == std::numeric_limits<Time>::max()) {
+        break;
+      }
+
+      clock_ = std::max(clock_, next_event);
+    }
+
+    Retire();
+    return sink_.Average();
+  }
+
+  const Sink& metrics() const { return sink_; }
+
+  Time clock() const { return clock_; }
+
+ private:
+  static constexpr std::size_t kIdle = std::numeric_limits<std::size_t>::max();
+
+  using ProcessType = BasicProcess<Time>;
+  using OrderType = ProcessOrder<Policy, ProcessType>;
+
+  struct Task {
+    ProcessTask::Handle handle;
+    Time at;
+    Time st;
+    Time cpu;             // CPU time used so far
+    Time waited;          // Time spent in the ready queue so far
+    Time ready_since;
+    bool dispatched;
+    std::size_t next_waiter{SimulatedLock::kNoTask};
+  };
+
+  void MakeReady(std::size_t index) {
+    tasks_[index].ready_since = clock_;
+    bursts_[index].at = clock_;
+    ready_.Push(index);
+  }
+
+  // Runs the process until its next request (or its end) and handles it.
+  void Resume(std::size_t index) {
+    auto& task{tasks_[index]};
+
+    task.handle.resume();
+
+    if (task.handle.done()) {
+      Complete(index);
+      return;
+    }
+
+    const auto request{task.handle.promise().request};
+    const auto amount{static_cast<Time>(std::max<std::int64_t>(request.amount, 0))};
+
+    switch (request.kind) {
+      case ProcessRequest::Kind::kCpu:
+        bursts_[index].bt = amount;
+        bursts_[index].rbt = amount;
+        task.cpu += amount;
+
+        if (amount == 0) {
+          resumable_.Push(index);
+        } else {
+          MakeReady(index);
+        }
+        break;
+      case ProcessRequest::Kind::kIo:
+        timers_.Schedule(clock_ + amount, index);
+        break;
+      case ProcessRequest::Kind::kAcquire:
+        Acquire(*request.lock, index);
+        break;
+      case ProcessRequest::Kind::kRelease:
+        Release(*request.lock);
+        resumable_.Push(index);
+        break;
+      case ProcessRequest::Kind::kNone:
+        resumable_.Push(index);
+        break;
+    }
+  }
+
+  void Acquire(SimulatedLock& lock, std::size_t index) {
+    if (!lock.used_) {
+      lock.used_ = true;
+      locks_.push_back(&lock);
+    }
+
+    if (!lock.held_) {
+      lock.held_ = true;
+      resumable_.Push(index);
+
+      return;
+    }
+
+    tasks_[index].next_waiter = SimulatedLock::kNoTask;
+
+    if (lock.last_waiter_ == SimulatedLock::kNoTask) {
+      lock.first_waiter_ = index;
+    } else {
+      tasks_[lock.last_waiter_].next_waiter = index;
+    }
+
+    lock.last_waiter_ = index;
+  }
+
+  // Hands the lock straight to the first waiter, if any.
+  void Release(SimulatedLock& lock) {
+    const auto waiter{lock.first_waiter_};
+
+    if (waiter == SimulatedLock::kNoTask) {
+      lock.held_ = false;
+      return;
+    }
+
+    lock.first_waiter_ = tasks_[waiter].next_waiter;
+    if (lock.first_waiter_ == SimulatedLock::kNoTask) {
+      lock.last_waiter_ = SimulatedLock::kNoTask;
+    }
+
+    resumable_.Push(waiter);
+  }
+
+  // Destroys the processes left unfinished and releases every lock used.
+  void Retire() {
+    for (auto& task : tasks_) {
+      if (task.handle) {
+        task.handle.destroy();
+      }
+    }
+
+    for (auto* lock : locks_) {
+      *lock = SimulatedLock{};
+    }
+
+    tasks_.clear();
+    bursts_.clear();
+    locks_.clear();
+  }
+
+  void Complete(std::size_t index) {
+    auto& task{tasks_[index]};
+
+    task.handle.destroy();
+    task.handle = {};
+
+    ProcessType process{.at = task.at, .bt = task.cpu, .st = task.st, .ct = clock_,
+                        .id = index, .finished = true};
+
+    process.tt = process.ct - process.at;
+    process.rt = task.dispatched ? process.st - process.at : process.tt;
+    process.wt = task.waited;
+
+    sink_.Record(process);
+  }
+
+  Policy policy_;
+  Sink sink_{};
+
+  std::vector<Task> tasks_{};
+  std::vector<ProcessType> bursts_{};  // Current CPU burst of each process
+  std::vector<SimulatedLock*> locks_{};  // Used by the current run
+
+  Queue<OrderType> ready_{};
+  FifoQueue<OrderType> resumable_{};                  // To resume at the current time
+  Timers<Time> timers_{};                             // I/O completions
+
+  Time clock_{};
+};
+
+using CoroutineFCFSScheduler = CoroutineScheduler<FCFSPolicy, FifoQueue>;
+using CoroutineSJFScheduler = CoroutineScheduler<SJFPolicy, HeapQueue>;
+using CoroutineRRScheduler = CoroutineScheduler<RRPolicy, FifoQueue>;
+}  // namespace ps
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ps {
+// Hot-path counters of a scheduler run. Schedulers take the counters type as
+// a template parameter and only touch it behind `if constexpr (kEnabled)`, so
+// with NullCounters neither the increments nor the storage exist.
+struct SchedulerCounters {
+  static constexpr bool kEnabled = true;
+
+  constexpr void Reset() { *this = {}; }
+
+  std::uint64_t events;       // Dispatches: one per slice run
+  std::uint64_t pushes;       // Ready queue pushes (arrivals and requeues)
+  std::uint64_t pops;         // Ready queue pops
+  std::uint64_t comparisons;  // Policy comparisons made by the ready queue
+  std::uint64_t idle_ticks;   // Time units the CPU spent idle
+  std::uint64_t rescans;      // Passes over the arrivals looking for new ones
+};
+
+struct NullCounters {
+  static constexpr bool kEnabled = false;
+
+  constexpr void Reset() {}
+};
+
+// Build with -DPS_ENABLE_COUNTERS to count in every scheduler by default.
+#ifdef PS_ENABLE_COUNTERS
+using DefaultCounters = SchedulerCounters;
+#else
+using DefaultCounters = NullCounters;
+#endif
+}  // namespace ps
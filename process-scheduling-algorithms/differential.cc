@@ -0,0 +1,605 @@
+// Differential driver: runs random workloads through the optimized schedulers
+// and through the reference oracles (reference.h) and stops at the first
+// schedule that differs, printing it in the processes file format so it can
+// be replayed with main.
+//
+// Besides the plain runs, every workload also goes through the arena
+// (ArenaScheduler) and memory resource (PmrScheduler) variants and through a
+// random queue limit, and every 64th one is checkpointed halfway and finished
+// from the checkpoint, in the temporary directory. The metrics main prints
+// (ColumnarMetricsSink, metrics_pass.h) are checked with and without the queue
+// limit; build once with -mavx2 as well to check its AVX2 path.
+//
+//   g++ -std=c++20 -O2 -pthread differential.cc -o differential
+//   ./differential --iterations=1000000 --seed=1
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "admission.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "metrics_pass.h"
+#include "online_scheduler.h"
+#include "reference.h"
+#include "scheduler.h"
+#include "workload.h"
+
+namespace {
+struct Options {
+  std::uint64_t iterations{100'000};
+  std::uint64_t seed{1};
+  std::size_t threads;  // 0: every hardware thread
+};
+
+struct Case {
+  std::vector<ps::Process> workload;
+  int quantum;
+  ps::QueueLimit limit;              // For the bounded runs
+  std::size_t checkpoint_after;      // Dispatches between checkpoints
+};
+
+// Checkpoints hit the disk, so only some workloads are resumed.
+constexpr std::uint64_t kCheckpointEvery{64};
+
+constexpr const char* kAdmissionNames[]{"reject", "drop-oldest", "delay"};
+
+struct Divergence {
+  std::uint64_t iteration;
+  std::string algorithm;
+  std::string detail;
+  Case input;
+};
+
+// Small workloads with many arrival ties and idle gaps, where the two
+// implementations take different paths.
+Case MakeCase(std::uint64_t seed) {
+  std::mt19937_64 engine{seed};
+
+  const auto pick = [&](std::uint64_t count) { return engine() % count; };
+
+  constexpr double kMeanGaps[]{0.5, 2.0, 8.0, 30.0};
+  constexpr double kMeanBursts[]{1.0, 4.0, 12.0};
+
+  ps::WorkloadGenerator generator{
+      {.seed = engine(),
+       .arrivals = static_cast<ps::ArrivalPattern>(pick(2)),
+       .mean_gap = kMeanGaps[pick(std::size(kMeanGaps))],
+       .bursts = static_cast<ps::BurstDistribution>(pick(3)),
+       .mean_burst = kMeanBursts[pick(std::size(kMeanBursts))]}};
+
+  Case result{.quantum = 1 + static_cast<int>(pick(8))};
+  ps::TakeInto(generator, 1 + pick(48), result.workload);
+
+  // Unbounded a quarter of the time, which the plain runs cover anyway.
+  result.limit = {.capacity = pick(9) * static_cast<std::size_t>(pick(4) > 0),
+                  .admission = static_cast<ps::Admission>(pick(3))};
+  result.checkpoint_after = 1 + pick(2 * result.workload.size());
+
+  return result;
+}
+
+// First process whose start, completion or metrics differ, or that only one
+// of them dropped, if any.
+template <typename Processes>
+std::optional<std::string> CompareSchedules(const std::vector<ps::Process>& expected,
+                                            const Processes& actual) {
+  std::vector<const ps::Process*> by_id(expected.size());
+  for (const auto& process : expected) {
+    by_id[process.id] = &process;
+  }
+
+  for (const auto& process : actual) {
+    const auto& oracle{*by_id[process.id]};
+
+    if (process.dropped != oracle.dropped) {
+      std::ostringstream detail_stream{};
+      detail_stream << "process " << process.id << (process.dropped ? " dropped" : " kept")
+                    << ", expected " << (oracle.dropped ? "dropped" : "kept");
+
+      return detail_stream.str();
+    }
+
+    if (process.dropped) {
+      continue;
+    }
+
+    if (process.st != oracle.st || process.ct != oracle.ct) {
+      std::ostringstream detail_stream{};
+      detail_stream << "process " << process.id << ": st " << process.st << " ct " << process.ct
+                    << ", expected st " << oracle.st << " ct " << oracle.ct;
+
+      return detail_stream.str();
+    }
+
+    if (process.tt != oracle.tt || process.rt != oracle.rt || process.wt != oracle.wt) {
+      std::ostringstream detail_stream{};
+      detail_stream << "process " << process.id << ": tt " << process.tt << " rt " << process.rt
+                    << " wt " << process.wt << ", expected tt " << oracle.tt << " rt "
+                    << oracle.rt << " wt " << oracle.wt;
+
+      return detail_stream.str();
+    }
+  }
+
+  return std::nullopt;
+}
+
+// Runs the workload with the sink main uses, which derives every process's
+// metrics in one pass once the run completes, and also compares their sums,
+// minima and maxima.
+template <typename Scheduler, typename Policy>
+std::optional<std::string> CompareColumnar(const std::vector<ps::Process>& expected,
+                                           const std::vector<ps::Process>& workload,
+                                           ps::QueueLimit limit, Policy policy) {
+  Scheduler scheduler{workload, policy};
+  scheduler.set_queue_limit(limit);
+  scheduler.Start();
+
+  if (auto detail{CompareSchedules(expected, scheduler.processes())}) {
+    return detail;
+  }
+
+  ps::MetricsSummary oracle{};
+  for (const auto& process : expected) {
+    if (process.dropped) {
+      continue;
+    }
+
+    oracle.count++;
+    oracle.tt.Merge({.sum = process.tt, .min = process.tt, .max = process.tt});
+    oracle.rt.Merge({.sum = process.rt, .min = process.rt, .max = process.rt});
+    oracle.wt.Merge({.sum = process.wt, .min = process.wt, .max = process.wt});
+  }
+
+  const auto& metrics{scheduler.metrics()};
+  const auto& summary{metrics.summary};
+
+  const auto same = [](const ps::MetricRange& lhs, const ps::MetricRange& rhs) {
+    return lhs.sum == rhs.sum && lhs.min == rhs.min && lhs.max == rhs.max;
+  };
+
+  if (summary.count != oracle.count || metrics.count != oracle.count ||
+      !same(summary.tt, oracle.tt) || !same(summary.rt, oracle.rt) ||
+      !same(summary.wt, oracle.wt) ||
+      metrics.tt != static_cast<double>(oracle.tt.sum) ||
+      metrics.rt != static_cast<double>(oracle.rt.sum) ||
+      metrics.wt != static_cast<double>(oracle.wt.sum)) {
+    const auto print = [](std::ostream& output, const char* name, const ps::MetricRange& range) {
+      output << " " << name << " " << range.sum << " [" << range.min << ", " << range.max << "]";
+    };
+
+    std::ostringstream detail_stream{};
+    detail_stream << summary.count << " processes, sums";
+    print(detail_stream, "tt", summary.tt);
+    print(detail_stream, "rt", summary.rt);
+    print(detail_stream, "wt", summary.wt);
+
+    detail_stream << ", expected " << oracle.count << ", sums";
+    print(detail_stream, "tt", oracle.tt);
+    print(detail_stream, "rt", oracle.rt);
+    print(detail_stream, "wt", oracle.wt);
+
+    return detail_stream.str();
+  }
+
+  return std::nullopt;
+}
+
+// Streams the workload into an online scheduler and compares the metric sums,
+// which are exact in double for integer times.
+template <typename Online>
+std::optional<std::string> CompareOnline(const std::vector<ps::Process>& expected,
+                                         const std::vector<ps::Process>& workload,
+                                         Online scheduler) {
+  for (const auto& process : workload) {
+    scheduler.AdvanceTo(process.at);
+    scheduler.Submit(process);
+  }
+
+  scheduler.Drain();
+
+  ps::AverageMetricsSink oracle{};
+  for (const auto& process : expected) {
+    oracle.Record(process);
+  }
+
+  const auto& metrics{scheduler.metrics()};
+  if (metrics.count != oracle.count || metrics.tt != oracle.tt || metrics.rt != oracle.rt ||
+      metrics.wt != oracle.wt) {
+    std::ostringstream detail_stream{};
+    detail_stream << "sums tt " << metrics.tt << " rt " << metrics.rt << " wt " << metrics.wt
+                  << ", expected tt " << oracle.tt << " rt " << oracle.rt << " wt " << oracle.wt;
+
+    return detail_stream.str();
+  }
+
+  return std::nullopt;
+}
+
+// Runs the workload in a per-thread arena, as a batch of runs would.
+template <typename Scheduler, typename Policy>
+std::optional<std::string> CompareInArena(const std::vector<ps::Process>& expected,
+                                          const std::vector<ps::Process>& workload,
+                                          Policy policy) {
+  thread_local ps::RunArena arena{};
+
+  Scheduler scheduler{workload, policy, arena.Begin(Scheduler::ArenaBytes(workload.size()))};
+  scheduler.Start();
+
+  return CompareSchedules(expected, scheduler.processes());
+}
+
+// Runs the workload with a per-thread pool resource that outlives the runs.
+template <typename Scheduler, typename Policy>
+std::optional<std::string> CompareInResource(const std::vector<ps::Process>& expected,
+                                             const std::vector<ps::Process>& workload,
+                                             Policy policy) {
+  thread_local std::pmr::unsynchronized_pool_resource resource{};
+
+  Scheduler scheduler{workload, policy, &resource};
+  scheduler.Start();
+
+  return CompareSchedules(expected, scheduler.processes());
+}
+
+template <typename Scheduler, typename Policy>
+std::optional<std::string> CompareBounded(const std::vector<ps::Process>& expected,
+                                          const Case& input, Policy policy) {
+  Scheduler scheduler{input.workload, policy};
+  scheduler.set_queue_limit(input.limit);
+  scheduler.Start();
+
+  return CompareSchedules(expected, scheduler.processes());
+}
+
+// Saves the bounded run twice, `checkpoint_after` dispatches apart, then
+// finishes it in a fresh scheduler restored from the newest checkpoint.
+template <typename Scheduler, typename Policy>
+std::optional<std::string> CompareResumed(const std::vector<ps::Process>& expected,
+                                          const Case& input, Policy policy,
+                                          const std::filesystem::path& filepath) {
+  {
+    Scheduler interrupted{input.workload, policy};
+    interrupted.set_queue_limit(input.limit);
+    interrupted.Begin();
+
+    ps::Checkpointer checkpointer{interrupted, filepath};
+    for (int i = 0; i < 2; i++) {
+      interrupted.Step(input.checkpoint_after);
+
+      if (!checkpointer.Save()) {
+        checkpointer.Remove();
+        return "unable to save a checkpoint: " + filepath.string();
+      }
+    }
+  }
+
+  Scheduler resumed{input.workload, policy};
+  resumed.set_queue_limit(input.limit);
+
+  ps::Checkpointer checkpointer{resumed, filepath};
+  const bool loaded{checkpointer.Load()};
+
+  if (loaded) {
+    while (resumed.Step(std::numeric_limits<std::size_t>::max())) {
+    }
+  }
+
+  checkpointer.Remove();
+
+  if (!loaded) {
+    return "checkpoint not resumed: " + filepath.string();
+  }
+
+  return CompareSchedules(expected, resumed.processes());
+}
+
+std::optional<Divergence> Check(std::uint64_t iteration, const Case& input) {
+  const auto& workload{input.workload};
+
+  const auto diverged = [&](const std::string& algorithm,
+                            const std::optional<std::string>& detail) -> std::optional<Divergence> {
+    if (!detail) {
+      return std::nullopt;
+    }
+
+    return Divergence{iteration, algorithm, *detail, input};
+  };
+
+  ps::reference::FCFSScheduler fcfs_oracle{workload};
+  ps::reference::SJFScheduler sjf_oracle{workload};
+  ps::reference::RRScheduler rr_oracle{workload, input.quantum};
+
+  fcfs_oracle.Start();
+  sjf_oracle.Start();
+  rr_oracle.Start();
+
+  using Sink = ps::AverageMetricsSink;
+
+  ps::BasicScheduler<ps::FCFSPolicy, ps::FifoQueue, int, Sink> fcfs{workload};
+  ps::BasicScheduler<ps::FCFSPolicy, ps::HeapQueue, int, Sink> fcfs_heap{workload};
+  ps::BasicScheduler<ps::SJFPolicy, ps::HeapQueue, int, Sink> sjf{workload};
+  ps::BasicScheduler<ps::RRPolicy, ps::FifoQueue, int, Sink> rr{workload, input.quantum};
+
+  fcfs.Start();
+  fcfs_heap.Start();
+  sjf.Start();
+  rr.Start();
+
+  const auto& fcfs_expected{fcfs_oracle.processes()};
+  const auto& sjf_expected{sjf_oracle.processes()};
+  const auto& rr_expected{rr_oracle.processes()};
+
+  if (auto divergence{diverged("FCFS", CompareSchedules(fcfs_expected, fcfs.processes()))}) {
+    return divergence;
+  }
+
+  if (auto divergence{
+          diverged("FCFS heap", CompareSchedules(fcfs_expected, fcfs_heap.processes()))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("SJF", CompareSchedules(sjf_expected, sjf.processes()))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("RR", CompareSchedules(rr_expected, rr.processes()))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged(
+          "Online FCFS", CompareOnline(fcfs_expected, workload, ps::OnlineFCFSScheduler{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged(
+          "Online SJF", CompareOnline(sjf_expected, workload, ps::OnlineSJFScheduler{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Online RR", CompareOnline(rr_expected, workload,
+                                                         ps::OnlineRRScheduler{input.quantum}))}) {
+    return divergence;
+  }
+
+  using ArenaFCFS = ps::ArenaScheduler<ps::FCFSPolicy, ps::FifoQueue, int, Sink>;
+  using ArenaSJF = ps::ArenaScheduler<ps::SJFPolicy, ps::HeapQueue, int, Sink>;
+  using ArenaRR = ps::ArenaScheduler<ps::RRPolicy, ps::FifoQueue, int, Sink>;
+
+  if (auto divergence{diverged(
+          "Arena FCFS", CompareInArena<ArenaFCFS>(fcfs_expected, workload, ps::FCFSPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Arena SJF", CompareInArena<ArenaSJF>(sjf_expected, workload,
+                                                                     ps::SJFPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Arena RR", CompareInArena<ArenaRR>(rr_expected, workload,
+                                                                   ps::RRPolicy{input.quantum}))}) {
+    return divergence;
+  }
+
+  using PmrRR = ps::PmrScheduler<ps::RRPolicy, ps::FifoQueue, int, Sink>;
+
+  if (auto divergence{diverged("Pmr RR", CompareInResource<PmrRR>(rr_expected, workload,
+                                                                  ps::RRPolicy{input.quantum}))}) {
+    return divergence;
+  }
+
+  using BoundedFCFS = ps::BasicScheduler<ps::FCFSPolicy, ps::FifoQueue, int, Sink>;
+  using BoundedSJF = ps::BasicScheduler<ps::SJFPolicy, ps::HeapQueue, int, Sink>;
+  using BoundedRR = ps::BasicScheduler<ps::RRPolicy, ps::FifoQueue, int, Sink>;
+
+  ps::reference::BoundedScheduler<ps::FCFSPolicy> bounded_fcfs_oracle{workload, input.limit,
+                                                                      false};
+  ps::reference::BoundedScheduler<ps::SJFPolicy> bounded_sjf_oracle{workload, input.limit, true};
+  ps::reference::BoundedScheduler<ps::RRPolicy> bounded_rr_oracle{
+      workload, input.limit, false, ps::RRPolicy{input.quantum}};
+
+  bounded_fcfs_oracle.Start();
+  bounded_sjf_oracle.Start();
+  bounded_rr_oracle.Start();
+
+  const auto& bounded_fcfs_expected{bounded_fcfs_oracle.processes()};
+  const auto& bounded_sjf_expected{bounded_sjf_oracle.processes()};
+  const auto& bounded_rr_expected{bounded_rr_oracle.processes()};
+
+  if (auto divergence{diverged("Bounded FCFS",
+                               CompareBounded<BoundedFCFS>(bounded_fcfs_expected, input,
+                                                           ps::FCFSPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Bounded SJF", CompareBounded<BoundedSJF>(
+                                                  bounded_sjf_expected, input, ps::SJFPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Bounded RR",
+                               CompareBounded<BoundedRR>(bounded_rr_expected, input,
+                                                         ps::RRPolicy{input.quantum}))}) {
+    return divergence;
+  }
+
+  using Columnar = ps::ColumnarMetricsSink;
+  using ColumnarFCFS = ps::BasicScheduler<ps::FCFSPolicy, ps::FifoQueue, int, Columnar>;
+  using ColumnarSJF = ps::BasicScheduler<ps::SJFPolicy, ps::HeapQueue, int, Columnar>;
+  using ColumnarRR = ps::BasicScheduler<ps::RRPolicy, ps::FifoQueue, int, Columnar>;
+
+  if (auto divergence{diverged("Columnar FCFS",
+                               CompareColumnar<ColumnarFCFS>(fcfs_expected, workload, {},
+                                                             ps::FCFSPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Columnar SJF",
+                               CompareColumnar<ColumnarSJF>(sjf_expected, workload, {},
+                                                            ps::SJFPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Columnar RR",
+                               CompareColumnar<ColumnarRR>(rr_expected, workload, {},
+                                                           ps::RRPolicy{input.quantum}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Bounded columnar FCFS",
+                               CompareColumnar<ColumnarFCFS>(bounded_fcfs_expected, workload,
+                                                             input.limit, ps::FCFSPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Bounded columnar SJF",
+                               CompareColumnar<ColumnarSJF>(bounded_sjf_expected, workload,
+                                                            input.limit, ps::SJFPolicy{}))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Bounded columnar RR",
+                               CompareColumnar<ColumnarRR>(bounded_rr_expected, workload,
+                                                           input.limit,
+                                                           ps::RRPolicy{input.quantum}))}) {
+    return divergence;
+  }
+
+  if (iteration % kCheckpointEvery != 0) {
+    return std::nullopt;
+  }
+
+  const auto filepath{std::filesystem::temp_directory_path() /
+                      ("ps-differential-" + std::to_string(getpid()) + "-" +
+                       std::to_string(iteration) + ".checkpoint")};
+
+  if (auto divergence{diverged("Resumed FCFS",
+                               CompareResumed<BoundedFCFS>(bounded_fcfs_expected, input,
+                                                           ps::FCFSPolicy{}, filepath))}) {
+    return divergence;
+  }
+
+  if (auto divergence{diverged("Resumed SJF", CompareResumed<BoundedSJF>(bounded_sjf_expected,
+                                                                         input, ps::SJFPolicy{},
+                                                                         filepath))}) {
+    return divergence;
+  }
+
+  return diverged("Resumed RR", CompareResumed<BoundedRR>(bounded_rr_expected, input,
+                                                          ps::RRPolicy{input.quantum}, filepath));
+}
+
+// Reads the value of a "--name=value" argument.
+template <typename T>
+bool ParseValue(const std::string& argument, T& value) {
+  std::stringstream value_stream{argument.substr(argument.find('=') + 1)};
+  return static_cast<bool>(value_stream >> value) && value_stream.eof();
+}
+
+std::optional<Options> ParseOptions(int argc, char** argv) {
+  Options options{};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string argument{argv[i]};
+
+    if (argument.rfind("--iterations=", 0) == 0) {
+      if (!ParseValue(argument, options.iterations)) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--seed=", 0) == 0) {
+      if (!ParseValue(argument, options.seed)) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--threads=", 0) == 0) {
+      if (!ParseValue(argument, options.threads)) {
+        return std::nullopt;
+      }
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  return options;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const auto options{ParseOptions(argc, argv)};
+  if (!options) {
+    std::cerr << "Usage: " << argv[0] << " [--iterations=100000] [--seed=1] [--threads=0]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::atomic<std::uint64_t> next_iteration{};
+  std::optional<Divergence> first_divergence{};
+  std::mutex divergence_mutex{};
+
+  // Every thread keeps going until the iterations run out or a divergence is
+  // found, and the earliest one is reported, so the output does not depend
+  // on the thread count.
+  auto work = [&] {
+    for (auto iteration{next_iteration++}; iteration < options->iterations;
+         iteration = next_iteration++) {
+      auto divergence{Check(iteration, MakeCase(options->seed + iteration))};
+      if (!divergence) {
+        continue;
+      }
+
+      std::lock_guard lock{divergence_mutex};
+      if (!first_divergence || iteration < first_divergence->iteration) {
+        first_divergence = std::move(divergence);
+      }
+
+      next_iteration = options->iterations;
+    }
+  };
+
+  const auto thread_count{options->threads > 0
+                              ? options->threads
+                              : std::max<std::size_t>(std::thread::hardware_concurrency(), 1)};
+
+  {
+    std::vector<std::jthread> threads{};
+    for (std::size_t i = 1; i < thread_count; i++) {
+      threads.emplace_back(work);
+    }
+
+    work();
+  }
+
+  if (!first_divergence) {
+    std::cout << options->iterations << " workloads, no divergence" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  const auto& divergence{*first_divergence};
+
+  std::cout << divergence.algorithm << " diverges at iteration " << divergence.iteration
+            << " (seed " << options->seed + divergence.iteration << ", quantum "
+            << divergence.input.quantum << ", queue capacity " << divergence.input.limit.capacity
+            << " " << kAdmissionNames[static_cast<std::size_t>(divergence.input.limit.admission)]
+            << "): " << divergence.detail << std::endl;
+
+  for (const auto& process : divergence.input.workload) {
+    std::cout << process.at << " " << process.bt << std::endl;
+  }
+
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ready_queue.h"
+#include "scheduler.h"
+
+namespace ps {
+// A job runs as a sequence of steps: every call to `step` does a bounded piece
+// of work and returns true once the job is done. Step boundaries are the
+// job's yield points, where a preemptive policy may put it back in the queue.
+struct Job {
+  std::function<bool()> step;
+  std::chrono::microseconds cost;  // Declared cost (SJF orders by it)
+};
+
+// Runs real jobs on a pool of worker threads, picking the next job with the
+// same policies and queues as BasicScheduler. Times are microseconds since the
+// executor was created; a job's slice is policy.Slice(remaining declared
+// cost), and a job whose slice is shorter than that yields at the first step
+// boundary after the slice has elapsed (RR), otherwise it runs to completion.
+//
+// Completed jobs are measured like simulated processes (at = submit time,
+// bt = CPU time actually used), so the metrics can be compared with what
+// BasicScheduler predicts for the same arrivals and bursts.
+template <typename Policy, template <typename> class Queue>
+class BasicExecutor {
+ public:
+  using Time = std::int64_t;
+  using ProcessType = BasicProcess<Time>;
+
+  explicit BasicExecutor(std::size_t worker_count, Policy policy = {})
+      : policy_{policy}, ready_{OrderType{&processes_}}, started_at_{Clock::now()} {
+    for (std::size_t i = 0; i < std::max<std::size_t>(worker_count, 1); i++) {
+      workers_.emplace_back([this] { Work(); });
+    }
+  }
+
+  BasicExecutor(const BasicExecutor&) = delete;
+  BasicExecutor& operator=(const BasicExecutor&) = delete;
+
+  ~BasicExecutor() {
+    Wait();
+
+    {
+      std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+
+    ready_condition_.notify_all();
+
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Submit(Job job) {
+    {
+      std::lock_guard lock{mutex_};
+
+      const auto index{processes_.size()};
+      const Time cost{std::max<Time>(job.cost.count(), 1)};
+
+      jobs_.push_back(std::move(job));
+      cpu_times_.push_back(0);
+      processes_.push_back({.at = Now(), .bt = cost, .st = -1, .rbt = cost, .id = index});
+
+      ready_.Push(index);
+      outstanding_++;
+    }
+
+    ready_condition_.notify_one();
+  }
+
+  // Blocks until every submitted job has completed.
+  void Wait() {
+    std::unique_lock lock{mutex_};
+    idle_condition_.wait(lock, [this] { return outstanding_ == 0; });
+  }
+
+  // Measured metrics of the completed jobs. Call after Wait.
+  const HistogramMetricsSink& metrics() const { return sink_; }
+
+  // Completed jobs with their measured times. Call after Wait.
+  const std::vector<ProcessType>& processes() const { return processes_; }
+
+  Time Now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started_at_)
+        .count();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using OrderType = ProcessOrder<Policy, ProcessType>;
+
+  void Work() {
+    std::unique_lock lock{mutex_};
+
+    while (true) {
+      ready_condition_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+      if (ready_.empty()) {
+        return;
+      }
+
+      const auto index{ready_.Pop()};
+
+      Time slice{};
+      bool preemptive{};
+
+      {
+        auto& process{processes_[index]};
+
+        if (process.st < 0) {
+          process.st = Now();
+        }
+
+        slice = policy_.Slice(process.rbt);
+        preemptive = slice < process.rbt;
+      }
+
+      // Stable across Submit: jobs_ is a deque only appended to. processes_
+      // may be reallocated, so it is only touched with the lock held.
+      Job* job{&jobs_[index]};
+
+      lock.unlock();
+
+      const Time slice_start{Now()};
+      Time slice_end{slice_start};
+      bool done{};
+
+      do {
+        done = job->step();
+        slice_end = Now();
+      } while (!done && (!preemptive || slice_end - slice_start < slice));
+
+      lock.lock();
+
+      auto& process{processes_[index]};
+
+      cpu_times_[index] += slice_end - slice_start;
+      process.rbt = std::max<Time>(process.rbt - (slice_end - slice_start), 1);
+
+      if (!done) {
+        ready_.Push(index);
+        ready_condition_.notify_one();
+
+        continue;
+      }
+
+      process.ct = slice_end;
+      process.bt = cpu_times_[index];
+      process.tt = process.ct - process.at;
+      process.rt = process.st - process.at;
+      process.wt = process.tt - process.bt;
+      process.rbt = 0;
+      process.finished = true;
+
+      sink_.Record(process);
+
+      if (--outstanding_ == 0) {
+        idle_condition_.notify_all();
+      }
+    }
+  }
+
+  Policy policy_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_condition_;
+  std::condition_variable idle_condition_;
+
+  std::deque<Job> jobs_{};
+  std::vector<Time> cpu_times_{};
+  std::vector<ProcessType> processes_{};
+  Queue<OrderType> ready_;
+  HistogramMetricsSink sink_{};
+
+  std::size_t outstanding_{};
+  bool stopping_{};
+
+  const Clock::time_point started_at_;
+  std::vector<std::thread> workers_{};
+};
+
+using FCFSExecutor = BasicExecutor<FCFSPolicy, FifoQueue>;
+using SJFExecutor = BasicExecutor<SJFPolicy, HeapQueue>;
+using RRExecutor = BasicExecutor<RRPolicy, FifoQueue>;
+
+// Model of an executor with `cpu_count` workers: BasicScheduler's dispatch
+// rules on that many identical CPUs sharing one ready queue. Idle CPUs take
+// ready processes in CPU order. Slices that end at the same time are handled
+// in CPU order, and processes arriving then are queued before the preempted
+// ones are requeued. With one CPU, the results are those of BasicScheduler.
+template <typename Policy, template <typename> class Queue>
+ProcessAverageMetrics SimulateCpus(std::vector<BasicProcess<std::int64_t>> processes,
+                                   std::size_t cpu_count, Policy policy = {}) {
+  using Time = std::int64_t;
+  using ProcessType = BasicProcess<Time>;
+
+  struct Cpu {
+    std::optional<std::size_t> running;
+    Time slice_end;
+  };
+
+  std::sort(processes.begin(), processes.end(), [](const ProcessType& lhs, const ProcessType& rhs) {
+    return FCFSPolicy::Before(lhs, rhs);
+  });
+
+  for (auto& process : processes) {
+    process.rbt = process.bt;
+    process.finished = false;
+  }
+
+  Queue<ProcessOrder<Policy, ProcessType>> ready{ProcessOrder<Policy, ProcessType>{&processes}};
+  ready.Reserve(processes.size());
+
+  std::vector<Cpu> cpus(std::max<std::size_t>(cpu_count, 1));
+  std::vector<std::size_t> preempted{};
+  AverageMetricsSink sink{};
+
+  Time clock{};
+  std::size_t next_arrival{};
+  std::size_t finished_count{};
+
+  const auto admit = [&] {
+    while (next_arrival < processes.size() && processes[next_arrival].at <= clock) {
+      ready.Push(next_arrival++);
+    }
+  };
+
+  while (finished_count < processes.size()) {
+    admit();
+
+    for (auto& cpu : cpus) {
+      if (cpu.running || ready.empty()) {
+        continue;
+      }
+
+      const auto index{ready.Pop()};
+      auto& process{processes[index]};
+
+      if (process.rbt == process.bt) {
+        process.st = clock;
+      }
+
+      const Time slice{policy.Slice(process.rbt)};
+      process.rbt -= slice;
+
+      cpu = {index, clock + slice};
+    }
+
+    // On to the next slice end or arrival, whichever comes first.
+    Time next{std::numeric_limits<Time>::max()};
+    for (const auto& cpu : cpus) {
+      if (cpu.running) {
+        next = std::min(next, cpu.slice_end);
+      }
+    }
+
+    if (next_arrival < processes.size()) {
+      next = std::min(next, processes[next_arrival].at);
+    }
+
+    clock = next;
+    preempted.clear();
+
+    for (auto& cpu : cpus) {
+      if (!cpu.running || cpu.slice_end != clock) {
+        continue;
+      }
+
+      auto& process{processes[*cpu.running]};
+
+      if (process.rbt == 0) {
+        process.ct = clock;
+        process.tt = process.ct - process.at;
+        process.rt = process.st - process.at;
+        process.wt = process.tt - process.bt;
+        process.finished = true;
+
+        sink.Record(process);
+        finished_count++;
+      } else {
+        preempted.push_back(*cpu.running);
+      }
+
+      cpu.running.reset();
+    }
+
+    admit();
+
+    for (const auto index : preempted) {
+      ready.Push(index);
+    }
+  }
+
+  return sink.Average();
+}
+
+struct ExecutionComparison {
+  ProcessAverageMetrics measured;
+  ProcessAverageMetrics simulated;
+};
+
+// Replays `processes` as real jobs: each one is submitted at `at` time units
+// and busy-spins for `bt` steps of one time unit. The simulation is then run
+// on the arrivals and CPU times that were actually measured, with as many
+// CPUs as workers (SimulateCpus), so the two sets of metrics only differ by
+// the scheduling itself. Both are in time units; policy parameters (the RR
+// quantum) are in microseconds.
+template <typename Policy, template <typename> class Queue>
+ExecutionComparison Execute(const std::vector<Process>& processes,
+                            std::chrono::microseconds time_unit, std::size_t worker_count,
+                            Policy policy = {}) {
+  std::vector<const Process*> arrival_order{};
+  for (const auto& process : processes) {
+    arrival_order.push_back(&process);
+  }
+
+  std::stable_sort(arrival_order.begin(), arrival_order.end(),
+                   [](const Process* lhs, const Process* rhs) { return lhs->at < rhs->at; });
+
+  std::vector<BasicProcess<std::int64_t>> measured{};
+  HistogramMetricsSink measured_metrics{};
+
+  {
+    BasicExecutor<Policy, Queue> executor{worker_count, policy};
+    const auto started_at{std::chrono::steady_clock::now()};
+
+    for (const auto* process : arrival_order) {
+      std::this_thread::sleep_until(started_at + process->at * time_unit);
+
+      auto step = [remaining = process->bt, time_unit]() mutable {
+        const auto step_end{std::chrono::steady_clock::now() + time_unit};
+        while (std::chrono::steady_clock::now() < step_end) {
+        }
+
+        return --remaining <= 0;
+      };
+
+      executor.Submit({.step = step, .cost = process->bt * time_unit});
+    }
+
+    executor.Wait();
+
+    measured = executor.processes();
+    measured_metrics = executor.metrics();
+  }
+
+  const auto unit{static_cast<float>(time_unit.count())};
+  const auto to_units = [unit](ProcessAverageMetrics metrics) {
+    return ProcessAverageMetrics{metrics.tt / unit, metrics.rt / unit, metrics.wt / unit};
+  };
+
+  return {.measured = to_units(measured_metrics.Average()),
+          .simulated = to_units(SimulateCpus<Policy, Queue>(std::move(measured), worker_count,
+                                                             policy))};
+}
+}  // namespace ps
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "scheduler.h"
+#include "workload.h"
+
+namespace ps {
+// Mean of a metric over the trials and the half-width of its 95% confidence
+// interval (Student's t, since trial counts are often small).
+struct Estimate {
+  double mean;
+  double half_width;
+};
+
+struct MetricsEstimate {
+  Estimate tt;
+  Estimate rt;
+  Estimate wt;
+};
+
+struct MonteCarloOptions {
+  WorkloadOptions workload;    // Trial k uses workload.seed + k
+  std::size_t process_count{1000};
+  std::size_t trials{100};
+  std::size_t threads{};       // 0: every hardware thread
+};
+
+namespace detail {
+// Two-sided 97.5% quantiles of Student's t for 1..30 degrees of freedom.
+constexpr std::array<double, 30> kStudentT975{
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+constexpr double StudentT975(std::size_t degrees_of_freedom) {
+  if (degrees_of_freedom == 0) {
+    return 0.0;
+  }
+
+  if (degrees_of_freedom <= kStudentT975.size()) {
+    return kStudentT975[degrees_of_freedom - 1];
+  }
+
+  // Cornish-Fisher expansion around the normal quantile, within 1e-4 of the
+  // exact value from 31 degrees of freedom on (2.0395 at 31, 2.0211 at 40).
+  constexpr double z{1.959963984540054};
+  constexpr double z2{z * z};
+
+  const auto v{static_cast<double>(degrees_of_freedom)};
+
+  return z + z * (z2 + 1.0) / (4.0 * v) +
+         z * ((5.0 * z2 + 16.0) * z2 + 3.0) / (96.0 * v * v) +
+         z * (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) / (384.0 * v * v * v);
+}
+
+// Welford's running mean and variance, fed in trial order.
+struct RunningEstimate {
+  void Add(double value) {
+    count++;
+
+    const double delta{value - mean};
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+  }
+
+  Estimate Finish() const {
+    if (count < 2) {
+      return {mean, 0.0};
+    }
+
+    const double deviation{std::sqrt(m2 / static_cast<double>(count - 1))};
+    return {mean, StudentT975(count - 1) * deviation / std::sqrt(static_cast<double>(count))};
+  }
+
+  std::size_t count{};
+  double mean{};
+  double m2{};
+};
+}  // namespace detail
+
+// Runs `run` on options.trials seeded workloads spread over a pool of
+// threads. `run` takes a workload (std::vector<GeneratedProcess>) and returns
+// the average metrics of N policies as std::array<ProcessAverageMetrics, N>;
+// it is called concurrently, so it must not share mutable state.
+//
+// Every trial is stored at its own index and the estimates are reduced in
+// trial order once all threads are done, so the results are identical bit for
+// bit whatever the thread count. A single trial can be reproduced with
+// `--generate=process_count --seed=workload.seed + k`.
+template <std::size_t N, typename Run>
+std::array<MetricsEstimate, N> MonteCarlo(const MonteCarloOptions& options, Run run) {
+  std::vector<std::array<ProcessAverageMetrics, N>> trials(options.trials);
+  std::atomic<std::size_t> next_trial{};
+
+  auto work = [&] {
+    std::vector<GeneratedProcess> workload{};
+    workload.reserve(options.process_count);
+
+    for (auto trial{next_trial++}; trial < trials.size(); trial = next_trial++) {
+      auto workload_options{options.workload};
+      workload_options.seed += trial;
+
+      WorkloadGenerator generator{workload_options};
+      const auto processes{generator.Take(options.process_count)};
+
+      workload.assign(processes.begin(), processes.end());
+      trials[trial] = run(workload);
+    }
+  };
+
+  const auto thread_count{std::min<std::size_t>(
+      options.threads > 0 ? options.threads : std::max(std::thread::hardware_concurrency(), 1U),
+      std::max<std::size_t>(options.trials, 1))};
+
+  {
+    std::vector<std::jthread> threads{};
+    for (std::size_t i = 1; i < thread_count; i++) {
+      threads.emplace_back(work);
+    }
+
+    work();
+  }
+
+  std::array<MetricsEstimate, N> estimates{};
+
+  for (std::size_t policy = 0; policy < N; policy++) {
+    detail::RunningEstimate tt{};
+    detail::RunningEstimate rt{};
+    detail::RunningEstimate wt{};
+
+    for (const auto& trial : trials) {
+      tt.Add(trial[policy].tt);
+      rt.Add(trial[policy].rt);
+      wt.Add(trial[policy].wt);
+    }
+
+    estimates[policy] = {tt.Finish(), rt.Finish(), wt.Finish()};
+  }
+
+  return estimates;
+}
+}  // namespace ps
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+
+#include "scheduler.h"
+
+// Golden results for processes.txt, checked while compiling.
+namespace ps::golden {
+inline constexpr std::array<Process, 4> kProcesses{{
+    {.at = 0, .bt = 20, .id = 0},
+    {.at = 0, .bt = 10, .id = 1},
+    {.at = 4, .bt = 6, .id = 2},
+    {.at = 4, .bt = 8, .id = 3},
+}};
+
+constexpr bool Matches(const ProcessAverageMetrics& metrics, float tt, float rt, float wt) {
+  return metrics.tt == tt && metrics.rt == rt && metrics.wt == wt;
+}
+
+static_assert(Matches(Simulate<FCFSPolicy, FifoQueue>(kProcesses), 30.5F, 19.5F, 19.5F));
+static_assert(Matches(Simulate<SJFPolicy, HeapQueue>(kProcesses), 21.5F, 10.5F, 10.5F));
+static_assert(Matches(Simulate<RRPolicy, FifoQueue>(kProcesses, RRPolicy{2}), 31.5F, 2.0F, 20.5F));
+
+// Any policy can use any queue: FCFS through a heap ordered by arrival.
+static_assert(Matches(Simulate<FCFSPolicy, HeapQueue>(kProcesses), 30.5F, 19.5F, 19.5F));
+
+// A quantum at least as long as every burst turns RR into FCFS.
+inline constexpr auto kRRQuantumTable{RRQuantumTable<20>(kProcesses)};
+
+static_assert(Matches(kRRQuantumTable[2 - 1], 31.5F, 2.0F, 20.5F));
+static_assert(Matches(kRRQuantumTable[20 - 1], 30.5F, 19.5F, 19.5F));
+}  // namespace ps::golden
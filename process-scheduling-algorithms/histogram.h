@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace ps {
+// Fixed-memory log-linear histogram in the spirit of HdrHistogram. Values below
+// kSubBucketCount are recorded exactly; larger values share a bucket with other
+// values within 1 / kSubBucketHalf (~1.6%) of them. Recording is a bit scan and
+// an increment, so it can sit inside the scheduling loops.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 7;
+  static constexpr std::uint64_t kSubBucketCount = 1ULL << kSubBucketBits;
+  static constexpr std::uint64_t kSubBucketHalf = kSubBucketCount / 2;
+  static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 2) * kSubBucketHalf;
+
+  void Record(std::int64_t value) {
+    const auto unsigned_value{value < 0 ? 0 : static_cast<std::uint64_t>(value)};
+
+    counts_[BucketOf(unsigned_value)]++;
+    total_++;
+
+    min_ = std::min(min_, unsigned_value);
+    max_ = std::max(max_, unsigned_value);
+  }
+
+  // Records values whose buckets were computed elsewhere (by a vectorized
+  // pass, see metrics_pass.h), given the least and greatest of those values.
+  void RecordBuckets(std::span<const std::uint32_t> buckets, std::uint64_t min,
+                     std::uint64_t max) {
+    for (const auto bucket : buckets) {
+      counts_[bucket]++;
+    }
+
+    total_ += buckets.size();
+
+    if (!buckets.empty()) {
+      min_ = std::min(min_, min);
+      max_ = std::max(max_, max);
+    }
+  }
+
+  // Highest value equivalent to the value at `percentile` (0..100).
+  std::uint64_t Percentile(double percentile) const {
+    if (total_ == 0) {
+      return 0;
+    }
+
+    percentile = std::clamp(percentile, 0.0, 100.0);
+
+    auto rank{static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_)))};
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen{};
+    for (std::size_t index = 0; index < kBucketCount; index++) {
+      seen += counts_[index];
+
+      if (seen >= rank) {
+        return std::clamp(HighestEquivalentValue(index), min_, max_);
+      }
+    }
+
+    return max_;
+  }
+
+  void Reset() {
+    counts_.fill(0);
+    total_ = 0;
+    min_ = std::numeric_limits<std::uint64_t>::max();
+    max_ = 0;
+  }
+
+  std::uint64_t count() const { return total_; }
+  std::uint64_t min() const { return total_ == 0 ? 0 : min_; }
+  std::uint64_t max() const { return max_; }
+
+  // Index of the bucket counting `value`.
+  static constexpr std::size_t BucketOf(std::uint64_t value) {
+    if (value < kSubBucketCount) {
+      return value;
+    }
+
+    const auto shift{static_cast<std::uint64_t>(std::bit_width(value) - kSubBucketBits)};
+    return shift * kSubBucketHalf + (value >> shift);
+  }
+
+ private:
+  static std::uint64_t HighestEquivalentValue(std::size_t index) {
+    if (index < kSubBucketCount) {
+      return index;
+    }
+
+    const auto shift{index / kSubBucketHalf - 1};
+    const auto sub_bucket{index - shift * kSubBucketHalf};
+
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+  std::array<std::uint64_t, kBucketCount> counts_{};
+  std::uint64_t total_{};
+  std::uint64_t min_{std::numeric_limits<std::uint64_t>::max()};
+  std::uint64_t max_{};
+};
+}  // namespace ps
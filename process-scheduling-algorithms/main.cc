@@ -1,304 +1,712 @@
-#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <limits>
 #include <locale>
 #include <optional>
-#include <queue>
+#include <sstream>
 #include <string>
-#include <tuple>
+#include <thread>
 #include <vector>
 
-namespace ps {
-struct Process {
-  int at;   // Arrival time
-  int bt;   // Burst time
-  int st;   // Start time
-  int ct;   // Completion time (start time + burst time)
-  int tt;   // Turnaround time (completion time - arrival time)
-  int rt;   // Response time (start time - arrival time)
-  int wt;   // Wait time (turnaround time - burst time)
-  int rbt;  // Remaining burst time (used in RR)
-  bool queued;
-  bool finished;
+#include "../common/batch.h"
+#include "../common/perf_counters.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "executor.h"
+#include "experiment.h"
+#include "golden.h"
+#include "metrics_pass.h"
+#include "online_scheduler.h"
+#include "result_cache.h"
+#include "sched_trace.h"
+#include "scheduler.h"
+#include "swf.h"
+#include "workload.h"
+#include "workload_file.h"
+#include "workload_hash.h"
+
+// Custom numeric separator (",") for std output.
+class NumericSeparator : public std::numpunct<char> {
+  char do_decimal_point() const override { return ','; }
 };
 
-struct ProcessAverageMetrics {
-  float tt;
-  float rt;
-  float wt;
+struct Options {
+  std::filesystem::path filepath;
+  std::vector<double> percentiles{50.0, 99.0, 99.9};
+  std::filesystem::path trace_filepath;
+  std::size_t generate_count;  // Synthetic processes instead of a file, if not 0
+  bool stream;                 // Generated processes go straight to online schedulers
+  ps::WorkloadOptions workload;
+  int execute_unit_us;  // Runs real jobs, with time units of this many microseconds, if not 0
+  std::size_t workers{1};
+  bool sched_trace;  // The file is `perf sched script` or ftrace sched_switch output
+  std::optional<std::int64_t> trace_cpu;  // Only this CPU of the sched trace, if set
+  std::filesystem::path convert_filepath;  // Writes the workload as a binary .psb file instead
+  std::size_t monte_carlo_trials;  // Runs this many generated workloads instead, if not 0
+  std::size_t threads;             // Monte Carlo threads, 0 for every hardware thread
+  bool profile;                    // Hardware counters around every algorithm
+  bool batch;                      // Every input below, with no interaction
+  std::vector<std::string> batch_inputs;     // Files, directories or globs
+  std::filesystem::path output_filepath;     // Batch results, standard output if empty
+  std::filesystem::path checkpoint_filepath;  // Saves and resumes runs, per algorithm, if set
+  std::size_t checkpoint_interval{100'000'000};  // Dispatches between two checkpoints
+  std::filesystem::path cache_directory;  // Reuses and stores results there, if set
+  ps::QueueLimit queue_limit;             // Bounded ready queue, if the capacity is not 0
 };
 
-class Scheduler {
- public:
-  explicit Scheduler(std::vector<Process> processes)
-      : processes_(std::move(processes)), processes_count_{processes_.size()} {}
+std::optional<Options> ParseOptions(int argc, char** argv);
+
+// Reads a workload file by its format, mapping .psb files instead. Returns why
+// the file could not be read, if it could not. Lines that were skipped are
+// reported to `warnings`.
+std::optional<std::string> LoadFile(const std::filesystem::path& filepath, const Options& options,
+                                    std::vector<ps::Process>& processes,
+                                    std::optional<ps::MappedWorkload>& mapped,
+                                    std::ostream& warnings);
+
+// Prints what the kernel did for a sched trace, then runs every algorithm.
+void Schedule(const std::vector<ps::Process>& processes, const ps::MappedWorkload* mapped,
+              const Options& options, ps::TraceWriter* trace, std::ostream& output);
+
+// Runs `scheduler`, saving a checkpoint every options.checkpoint_interval
+// dispatches and resuming from the last one if there is one.
+template <typename Scheduler>
+ps::ProcessAverageMetrics StartWithCheckpoints(Scheduler& scheduler, const std::string& name,
+                                               const Options& options);
+
+// Runs every algorithm with Time wide enough for the workload.
+template <typename Time, typename Workload>
+void RunSchedulers(const Workload& processes, const Options& options, ps::TraceWriter* trace,
+                   std::ostream& output);
+
+// Feeds the generated workload to an online scheduler per algorithm as it is
+// generated, so memory is bounded by the live processes, not the count.
+void RunStream(const Options& options, std::ostream& output);
+
+// Runs every algorithm on real jobs and compares them with the simulation.
+void RunExecutors(const std::vector<ps::Process>& processes, const Options& options);
+
+// Runs every algorithm on many generated workloads and prints confidence intervals.
+void RunMonteCarlo(const Options& options);
 
-  virtual ~Scheduler() = default;
+// Schedules every batch input on a thread pool into one ordered output.
+int RunBatch(const Options& options);
 
-  virtual ProcessAverageMetrics Start() = 0;
+// Prints averages and then one line of percentiles per requested percentile.
+void PrintMetrics(std::ostream& output, const std::string& name,
+                  const ps::ProcessAverageMetrics& metrics, const ps::ProcessHistograms& histograms,
+                  const Options& options);
 
- protected:
-  void SortArrivalTimeAsceding() {
-    auto comparer = [](const Process& lhs, const Process& rhs) {
-      return lhs.at < rhs.at;
-    };
+std::vector<ps::Process> ParseFile(const std::filesystem::path& filepath);
+
+int main(int argc, char** argv) {
+  std::cout.imbue(std::locale(std::cout.getloc(), new NumericSeparator));
 
-    std::sort(processes_.begin(), processes_.end(), comparer);
+  const auto options{ParseOptions(argc, argv)};
+  if (!options) {
+    std::cout << "Usage: "
+              << std::filesystem::path(argv[0]).filename().string()
+              << " [processes file or .swf log] [--percentiles=50,99,99.9] [--trace=file.json]\n"
+              << "       [--generate=count [--stream]] [--seed=42] [--arrivals=poisson|bursty]\n"
+              << "       [--bursts=exponential|pareto|bimodal]\n"
+              << "       [--execute=time unit in us] [--workers=1] [--sched-trace [--cpu=N]]\n"
+              << "       [--convert=file.psb] [--monte-carlo=trials] [--threads=0]\n"
+              << "       [--profile] [--batch files, directories or globs... [--output=file]]\n"
+              << "       [--checkpoint=file] [--checkpoint-interval=dispatches]\n"
+              << "       [--cache=directory]\n"
+              << "       [--queue-capacity=count] [--admission=reject|drop-oldest|delay]"
+              << std::endl;
+
+    std::cin.get();
+    return EXIT_SUCCESS;
   }
 
-  std::vector<Process> processes_;
-  std::size_t processes_count_;
-};
+  if (options->batch) {
+    return RunBatch(*options);
+  }
 
-class FCFSScheduler : public Scheduler {
- public:
-  explicit FCFSScheduler(const std::vector<Process>& processes) : Scheduler(processes) {}
+  if (options->monte_carlo_trials > 0) {
+    RunMonteCarlo(*options);
 
-  ~FCFSScheduler() override = default;
+    std::cin.get();
+    return EXIT_SUCCESS;
+  }
 
-  ProcessAverageMetrics Start() override {
-    ProcessAverageMetrics metrics{};
+  if (options->stream) {
+    RunStream(*options, std::cout);
 
-    SortArrivalTimeAsceding();
+    std::cin.get();
+    return EXIT_SUCCESS;
+  }
 
-    for (std::size_t i = 0; i < processes_count_; i++) {
-      auto& process{processes_[i]};
+  std::vector<ps::Process> processes{};
+  std::optional<ps::MappedWorkload> mapped{};
 
-      process.st = i == 0 ? process.at : std::max(process.at, processes_[i - 1].ct);
-      process.ct = process.st + process.bt;
+  if (options->generate_count > 0) {
+    ps::WorkloadGenerator generator{options->workload};
 
-      process.tt = process.ct - process.at;
-      process.rt = process.st - process.at;
-      process.wt = process.tt - process.bt;
+    if (!ps::TakeInto(generator, options->generate_count, processes)) {
+      std::cerr << "Generated arrivals exceed 32-bit times, use --stream" << std::endl;
 
-      metrics.tt += static_cast<float>(process.tt);
-      metrics.rt += static_cast<float>(process.rt);
-      metrics.wt += static_cast<float>(process.wt);
+      std::cin.get();
+      return EXIT_FAILURE;
     }
+  } else if (const auto error{LoadFile(options->filepath, *options, processes, mapped, std::cerr)}) {
+    std::cerr << *error << std::endl;
 
-    metrics.tt /= static_cast<float>(processes_count_);
-    metrics.rt /= static_cast<float>(processes_count_);
-    metrics.wt /= static_cast<float>(processes_count_);
+    std::cin.get();
+    return EXIT_FAILURE;
+  }
 
-    return metrics;
+  // Only the schedulers are built from a mapped workload directly.
+  if (mapped && (options->execute_unit_us > 0 || !options->convert_filepath.empty())) {
+    processes.assign(mapped->begin(), mapped->end());
+    mapped.reset();
   }
-};
 
-class SJFScheduler : public Scheduler {
- public:
-  explicit SJFScheduler(const std::vector<Process>& processes) : Scheduler(processes) {}
+  if (processes.empty() && (!mapped || mapped->empty())) {
+    std::cout << "No process to schedule." << std::endl;
 
-  ~SJFScheduler() override = default;
+    std::cin.get();
+    return EXIT_SUCCESS;
+  }
 
-  ProcessAverageMetrics Start() override {
-    ProcessAverageMetrics metrics{};
+  if (!options->convert_filepath.empty()) {
+    // A .psb file keeps the processes, not the schedule the kernel made.
+    if (options->sched_trace) {
+      std::cerr << "A sched trace cannot be converted without losing the kernel's schedule"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
 
-    int time_passed{};
+    if (!ps::WriteWorkloadFile(options->convert_filepath, processes)) {
+      std::cerr << "Unable to write workload: " + options->convert_filepath.string() << std::endl;
+      return EXIT_FAILURE;
+    }
 
-    std::size_t finished_count{};
-    while (finished_count < processes_count_) {
-      Process* pProcess{};
+    return EXIT_SUCCESS;
+  }
 
-      int bt_threshold = std::numeric_limits<int>::max();
+  std::optional<ps::TraceWriter> trace{};
+  if (!options->trace_filepath.empty()) {
+    trace.emplace(options->trace_filepath);
 
-      for (auto& process : processes_) {
-        if (process.finished || process.at > time_passed) {
-          continue;
-        }
+    if (!trace->is_open()) {
+      std::cerr << "Unable to write trace: " + options->trace_filepath.string() << std::endl;
 
-        bool found{process.bt < bt_threshold};
-        if (process.bt == bt_threshold && pProcess) {
-          found = process.at < pProcess->at;
-        }
+      std::cin.get();
+      return EXIT_FAILURE;
+    }
+  }
 
-        if (found) {
-          bt_threshold = process.bt;
-          pProcess = &process;
-        }
-      }
+  if (options->execute_unit_us > 0) {
+    RunExecutors(processes, *options);
+  } else {
+    Schedule(processes, mapped ? &*mapped : nullptr, *options, trace ? &*trace : nullptr,
+             std::cout);
+  }
 
-      if (!pProcess) {
-        time_passed++;
-        continue;
-      }
+  // Blocks are written as the runs go, so a full disk only shows up here.
+  if (trace && !trace->Close()) {
+    std::cerr << "Unable to write trace: " + options->trace_filepath.string() << std::endl;
 
-      pProcess->st = time_passed;
-      pProcess->ct = pProcess->st + pProcess->bt;
+    std::cin.get();
+    return EXIT_FAILURE;
+  }
 
-      pProcess->tt = pProcess->ct - pProcess->at;
-      pProcess->rt = pProcess->st - pProcess->at;
-      pProcess->wt = pProcess->tt - pProcess->bt;
+  std::cin.get();
+}
 
-      time_passed = pProcess->ct;
+std::optional<std::string> LoadFile(const std::filesystem::path& filepath, const Options& options,
+                                    std::vector<ps::Process>& processes,
+                                    std::optional<ps::MappedWorkload>& mapped,
+                                    std::ostream& warnings) {
+  if (!std::filesystem::exists(filepath)) {
+    return "File not found: " + filepath.string();
+  }
 
-      metrics.tt += static_cast<float>(pProcess->tt);
-      metrics.rt += static_cast<float>(pProcess->rt);
-      metrics.wt += static_cast<float>(pProcess->wt);
+  if (options.sched_trace) {
+    ps::SchedTraceStatus status{};
+    processes = ps::ReadSchedTrace(filepath, options.trace_cpu, &status);
 
-      pProcess->finished = true;
-      finished_count++;
+    if (status.overflowed) {
+      return "Trace too long for 32-bit microsecond times (about 35 minutes): " +
+             filepath.string();
     }
 
-    metrics.tt /= static_cast<float>(processes_count_);
-    metrics.rt /= static_cast<float>(processes_count_);
-    metrics.wt /= static_cast<float>(processes_count_);
+    if (status.skipped > 0) {
+      warnings << "Skipped " << status.skipped << " unparsable sched events: " << filepath.string()
+               << "\n";
+    }
 
-    return metrics;
-  }
-};
+    if (status.out_of_order > 0) {
+      warnings << "Skipped " << status.out_of_order << " out-of-order sched events: "
+               << filepath.string() << "\n";
+    }
 
-class RRScheduler : public Scheduler {
- public:
-  explicit RRScheduler(const std::vector<Process>& processes, int quantum)
-      : quantum_{quantum}, Scheduler(processes) {}
+    // Most likely not a sched trace, or in a format that is not read.
+    if (processes.empty()) {
+      return "No complete burst in sched trace: " + filepath.string();
+    }
+  } else if (filepath.extension() == ".psb") {
+    mapped.emplace(filepath);
 
-  ~RRScheduler() override = default;
+    if (!mapped->is_open()) {
+      return "Bad workload file: " + filepath.string();
+    }
+  } else if (filepath.extension() == ".swf") {
+    std::size_t skipped{};
+    processes = ps::ReadSwf(filepath, &skipped);
 
-  ProcessAverageMetrics Start() override {
-    SortArrivalTimeAsceding();
+    if (skipped > 0) {
+      warnings << "Skipped " << skipped << " unusable job lines: " << filepath.string() << "\n";
+    }
+  } else {
+    processes = ParseFile(filepath);
+  }
 
-    ProcessAverageMetrics metrics{};
+  return std::nullopt;
+}
 
-    int time_passed{};
+void Schedule(const std::vector<ps::Process>& processes, const ps::MappedWorkload* mapped,
+              const Options& options, ps::TraceWriter* trace, std::ostream& output) {
+  // What the kernel actually did, to compare with the policies below.
+  if (options.sched_trace) {
+    ps::HistogramMetricsSink kernel{};
+    for (const auto& process : processes) {
+      kernel.Record(process);
+    }
 
-    std::queue<std::size_t> ready_indexes_queue{};
+    PrintMetrics(output, "Kernel", kernel.Average(), kernel.histograms, options);
+  }
 
-    ready_indexes_queue.push(0);
+  const auto schedule = [&](const auto& workload) {
+    if (ps::FitsTime<int>(workload)) {
+      RunSchedulers<int>(workload, options, trace, output);
+    } else {
+      RunSchedulers<std::int64_t>(workload, options, trace, output);
+    }
+  };
 
-    std::size_t finished_count{};
-    while (finished_count < processes_count_) {
-      const auto curr_index{ready_indexes_queue.front()};
-      auto& curr{processes_[curr_index]};
+  if (mapped) {
+    schedule(*mapped);
+  } else {
+    schedule(processes);
+  }
+}
 
-      ready_indexes_queue.pop();
+int RunBatch(const Options& options) {
+  const auto inputs{batch::ExpandInputs(options.batch_inputs)};
 
-      if (curr.rbt == curr.bt) {
-        curr.st = std::max(time_passed, curr.at);
-        time_passed = curr.st;
-      }
+  std::ofstream file_stream{};
+  if (!options.output_filepath.empty()) {
+    file_stream.open(options.output_filepath, std::ios::out | std::ios::trunc);
 
-      if (curr.rbt - quantum_ > 0) {
-        curr.rbt -= quantum_;
-        time_passed += quantum_;
-      } else {
-        time_passed += curr.rbt;
+    if (!file_stream) {
+      std::cerr << "Unable to write results: " + options.output_filepath.string() << std::endl;
+      return EXIT_FAILURE;
+    }
 
-        curr.ct = time_passed;
-        curr.tt = curr.ct - curr.at;
-        curr.rt = curr.st - curr.at;
-        curr.wt = curr.tt - curr.bt;
+    file_stream.imbue(std::cout.getloc());
+  }
 
-        metrics.tt += static_cast<float>(curr.tt);
-        metrics.rt += static_cast<float>(curr.rt);
-        metrics.wt += static_cast<float>(curr.wt);
+  auto& output{options.output_filepath.empty() ? static_cast<std::ostream&>(std::cout)
+                                               : file_stream};
 
-        curr.rbt = 0;
-        curr.finished = true;
+  const auto thread_count{options.threads > 0
+                              ? options.threads
+                              : std::max<std::size_t>(std::thread::hardware_concurrency(), 1)};
 
-        finished_count++;
-      }
+  // Each input is loaded, scheduled and formatted on a worker; only the
+  // formatted results of the next few inputs wait to be written.
+  const auto failures{batch::Run(
+      inputs, thread_count, 2 * thread_count,
+      [&](const std::filesystem::path& filepath, std::ostream& result) {
+        result << "== " << filepath.string() << "\n";
 
-      std::size_t next_index{1};
+        std::vector<ps::Process> processes{};
+        std::optional<ps::MappedWorkload> mapped{};
 
-      for (auto it = processes_.begin() + 1; it != processes_.end(); it++, next_index++) {
-        if (it->queued || it->finished) {
-          continue;
+        if (const auto error{LoadFile(filepath, options, processes, mapped, result)}) {
+          result << *error << "\n";
+          return false;
         }
 
-        if (it->at <= time_passed) {
-          ready_indexes_queue.push(next_index);
-          it->queued = true;
+        if (processes.empty() && (!mapped || mapped->empty())) {
+          result << "No process to schedule.\n";
+          return true;
         }
-      }
 
-      if (!curr.finished) {
-        ready_indexes_queue.push(curr_index);
-      }
+        Schedule(processes, mapped ? &*mapped : nullptr, options, nullptr, result);
+        return true;
+      },
+      output)};
 
-      if (ready_indexes_queue.empty()) {
-        next_index = 1;
+  if (failures > 0) {
+    std::cerr << failures << " of " << inputs.size() << " inputs failed" << std::endl;
+  }
 
-        for (auto it = processes_.begin() + 1; it != processes_.end();
-             it++, next_index++) {
-          if (it->finished) {
-            continue;
-          }
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
-          ready_indexes_queue.push(next_index);
-          it->queued = true;
+template <typename Time, typename Workload>
+void RunSchedulers(const Workload& processes, const Options& options, ps::TraceWriter* trace,
+                   std::ostream& output) {
+  std::optional<perf::Counters> counters{};
+  if (options.profile) {
+    counters.emplace();
 
-          break;
-        }
+    if (!counters->available()) {
+      std::cerr << "Hardware counters unavailable: " << counters->error() << std::endl;
+      counters.reset();
+    }
+  }
+
+  std::optional<ps::ResultCache> cache{};
+  std::uint64_t workload_hash{};
+
+  if (!options.cache_directory.empty()) {
+    cache.emplace(options.cache_directory);
+    workload_hash = ps::HashWorkload(processes);
+  }
+
+  const auto report = [&](const std::string& name, auto&& scheduler) {
+    const ps::ResultKey key{.workload_hash = workload_hash,
+                            .process_count = scheduler.processes().size(),
+                            .algorithm = name,
+                            .parameters = ps::PolicyParameters(scheduler.policy())};
+
+    // Traces and profiles need the run itself, and drops are not cached.
+    if (cache && !trace && !counters && options.queue_limit.capacity == 0) {
+      if (const auto cached{cache->Find(key)}) {
+        PrintMetrics(output, name, cached->metrics, cached->histograms, options);
+        return;
       }
     }
 
-    metrics.tt /= static_cast<float>(processes_count_);
-    metrics.rt /= static_cast<float>(processes_count_);
-    metrics.wt /= static_cast<float>(processes_count_);
+    if (trace) {
+      trace->BeginProcess(name);
+      scheduler.set_trace(trace);
+    }
+
+    scheduler.set_queue_limit(options.queue_limit);
 
-    return metrics;
+    if (counters) {
+      counters->Start();
+    }
+
+    const auto& metrics{options.checkpoint_filepath.empty()
+                            ? scheduler.Start()
+                            : StartWithCheckpoints(scheduler, name, options)};
+    const auto sample{counters ? counters->Stop() : perf::Sample{}};
+
+    if (cache && options.queue_limit.capacity == 0 &&
+        !cache->Store(key, {metrics, scheduler.histograms()})) {
+      std::cerr << "Unable to cache results in " << options.cache_directory.string() << std::endl;
+    }
+
+    PrintMetrics(output, name, metrics, scheduler.histograms(), options);
+
+    if (options.queue_limit.capacity > 0) {
+      const auto overload{scheduler.overload()};
+
+      output << "  dropped " << overload.dropped << " (" << overload.drop_rate * 100.0F
+             << "%) goodput " << std::setprecision(2) << overload.goodput << std::endl;
+    }
+
+    if (counters) {
+      output << "  ";
+      perf::Print(output, sample, scheduler.processes().size(), "process");
+      output << std::endl;
+    }
+
+    // Built with -DPS_ENABLE_COUNTERS.
+    if constexpr (ps::DefaultCounters::kEnabled) {
+      const auto& counts{scheduler.counters()};
+
+      output << "  events " << counts.events << " pushes " << counts.pushes << " pops "
+             << counts.pops << " comparisons " << counts.comparisons << " idle "
+             << counts.idle_ticks << " rescans " << counts.rescans << std::endl;
+    }
+  };
+
+  // Metrics are summarized in one pass once each run completes.
+  using Sink = ps::ColumnarMetricsSink;
+
+  report("FCFS", ps::BasicScheduler<ps::FCFSPolicy, ps::FifoQueue, Time, Sink>{processes});
+  report("SJF", ps::BasicScheduler<ps::SJFPolicy, ps::HeapQueue, Time, Sink>{processes});
+  report("RR", ps::BasicScheduler<ps::RRPolicy, ps::FifoQueue, Time, Sink>{processes, 2});
+}
+
+template <typename Scheduler>
+ps::ProcessAverageMetrics StartWithCheckpoints(Scheduler& scheduler, const std::string& name,
+                                               const Options& options) {
+  auto filepath{options.checkpoint_filepath};
+  filepath += "." + name;
+
+  ps::Checkpointer checkpointer{scheduler, filepath};
+
+  if (checkpointer.Load()) {
+    std::cerr << "Resuming " << name << " from " << filepath.string() << std::endl;
   }
 
- private:
-  int quantum_;
-};
-}  // namespace ps
+  while (scheduler.Step(options.checkpoint_interval)) {
+    if (!checkpointer.Save()) {
+      std::cerr << "Unable to write checkpoint: " + filepath.string() << std::endl;
+    }
+  }
 
-// Custom numeric separator (",") for std output.
-class NumericSeparator : public std::numpunct<char> {
-  char do_decimal_point() const override { return ','; }
-};
+  checkpointer.Remove();
+  return scheduler.metrics().Average();
+}
 
-std::vector<ps::Process> ParseFile(const std::filesystem::path& filepath);
+void RunStream(const Options& options, std::ostream& output) {
+  const auto report = [&](const std::string& name, auto scheduler) {
+    ps::WorkloadGenerator generator{options.workload};
 
-int main(int argc, char** argv) {
-  std::cout.imbue(std::locale(std::cout.getloc(), new NumericSeparator));
+    for (std::size_t i = 0; i < options.generate_count; i++) {
+      const auto process{generator.Next()};
 
-  if (argc < 2) {
-    std::cout << "Usage: "
-              << std::filesystem::path(argv[0]).filename().string()
-              << " [processes file]" << std::endl;
+      scheduler.AdvanceTo(process.at);
+      scheduler.Submit(process);
+    }
 
-    std::cin.get();
-    return EXIT_SUCCESS;
+    scheduler.Drain();
+
+    const auto& metrics{scheduler.metrics()};
+    PrintMetrics(output, name, metrics.Average(), metrics.histograms, options);
+  };
+
+  report("FCFS", ps::OnlineScheduler<ps::FCFSPolicy, ps::FifoQueue, std::int64_t>{});
+  report("SJF", ps::OnlineScheduler<ps::SJFPolicy, ps::HeapQueue, std::int64_t>{});
+  report("RR", ps::OnlineScheduler<ps::RRPolicy, ps::FifoQueue, std::int64_t>{ps::RRPolicy{2}});
+}
+
+void RunExecutors(const std::vector<ps::Process>& processes, const Options& options) {
+  const std::chrono::microseconds time_unit{options.execute_unit_us};
+
+  const auto report = [](const std::string& name, const ps::ExecutionComparison& comparison) {
+    std::cout << std::setprecision(1) << std::fixed << name << " real " << comparison.measured.tt
+              << " " << comparison.measured.rt << " " << comparison.measured.wt << std::endl;
+    std::cout << name << " model " << comparison.simulated.tt << " " << comparison.simulated.rt
+              << " " << comparison.simulated.wt << std::endl;
+  };
+
+  report("FCFS", ps::Execute<ps::FCFSPolicy, ps::FifoQueue>(processes, time_unit, options.workers));
+  report("SJF", ps::Execute<ps::SJFPolicy, ps::HeapQueue>(processes, time_unit, options.workers));
+  report("RR", ps::Execute<ps::RRPolicy, ps::FifoQueue>(processes, time_unit, options.workers,
+                                                        ps::RRPolicy{2 * options.execute_unit_us}));
+}
+
+void RunMonteCarlo(const Options& options) {
+  const ps::MonteCarloOptions experiment{
+      .workload = options.workload,
+      .process_count = options.generate_count > 0 ? options.generate_count : 1000,
+      .trials = options.monte_carlo_trials,
+      .threads = options.threads};
+
+  const auto estimates{ps::MonteCarlo<3>(experiment, [](const std::vector<ps::GeneratedProcess>& workload) {
+    using Sink = ps::AverageMetricsSink;
+    using FCFS = ps::ArenaScheduler<ps::FCFSPolicy, ps::FifoQueue, std::int64_t, Sink>;
+    using SJF = ps::ArenaScheduler<ps::SJFPolicy, ps::HeapQueue, std::int64_t, Sink>;
+    using RR = ps::ArenaScheduler<ps::RRPolicy, ps::FifoQueue, std::int64_t, Sink>;
+
+    // Every trial of a thread reuses its arena, so trials do not allocate.
+    thread_local ps::RunArena arena{};
+
+    const auto count{workload.size()};
+    const auto allocator{
+        arena.Begin(FCFS::ArenaBytes(count) + SJF::ArenaBytes(count) + RR::ArenaBytes(count))};
+
+    return std::array{FCFS{workload, {}, allocator}.Start(), SJF{workload, {}, allocator}.Start(),
+                      RR{workload, ps::RRPolicy{2}, allocator}.Start()};
+  })};
+
+  const std::array<std::string, 3> names{"FCFS", "SJF", "RR"};
+
+  for (std::size_t i = 0; i < names.size(); i++) {
+    const auto& estimate{estimates[i]};
+
+    std::cout << std::setprecision(2) << std::fixed << names[i] << " " << estimate.tt.mean
+              << "±" << estimate.tt.half_width << " " << estimate.rt.mean << "±"
+              << estimate.rt.half_width << " " << estimate.wt.mean << "±"
+              << estimate.wt.half_width << std::endl;
   }
+}
 
-  const std::filesystem::path filepath{argv[1]};
-  if (!std::filesystem::exists(filepath)) {
-    std::cerr << "File not found: " + filepath.string() << std::endl;
+void PrintMetrics(std::ostream& output, const std::string& name,
+                  const ps::ProcessAverageMetrics& metrics, const ps::ProcessHistograms& histograms,
+                  const Options& options) {
+  output << std::setprecision(1) << std::fixed << name << " " << metrics.tt << " "
+         << metrics.rt << " " << metrics.wt << std::endl;
 
-    std::cin.get();
-    return EXIT_FAILURE;
+  for (const double percentile : options.percentiles) {
+    std::ostringstream label_stream{};
+    label_stream << "p" << percentile;
+
+    output << "  " << label_stream.str() << " "
+           << histograms.tt.Percentile(percentile) << " "
+           << histograms.rt.Percentile(percentile) << " "
+           << histograms.wt.Percentile(percentile) << std::endl;
   }
+}
 
-  const auto& processes{ParseFile(filepath)};
-  if (processes.empty()) {
-    std::cout << "No process to schedule." << std::endl;
+// Reads the value of a "--name=value" argument.
+template <typename T>
+bool ParseValue(const std::string& argument, T& value) {
+  std::stringstream value_stream{argument.substr(argument.find('=') + 1)};
+  return static_cast<bool>(value_stream >> value) && value_stream.eof();
+}
 
-    std::cin.get();
-    return EXIT_SUCCESS;
+std::optional<Options> ParseOptions(int argc, char** argv) {
+  Options options{};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string argument{argv[i]};
+
+    if (argument.rfind("--percentiles=", 0) == 0) {
+      options.percentiles.clear();
+
+      std::stringstream list_stream{argument.substr(argument.find('=') + 1)};
+      std::string token{};
+
+      while (std::getline(list_stream, token, ',')) {
+        std::stringstream token_stream{token};
+
+        double percentile{};
+        if (!(token_stream >> percentile) || percentile < 0.0 || percentile > 100.0) {
+          std::cerr << "Bad percentile: " << token << std::endl;
+          return std::nullopt;
+        }
+
+        options.percentiles.push_back(percentile);
+      }
+    } else if (argument.rfind("--trace=", 0) == 0) {
+      options.trace_filepath = argument.substr(argument.find('=') + 1);
+    } else if (argument.rfind("--generate=", 0) == 0) {
+      if (!ParseValue(argument, options.generate_count)) {
+        return std::nullopt;
+      }
+    } else if (argument == "--stream") {
+      options.stream = true;
+    } else if (argument.rfind("--seed=", 0) == 0) {
+      if (!ParseValue(argument, options.workload.seed)) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--execute=", 0) == 0) {
+      if (!ParseValue(argument, options.execute_unit_us) || options.execute_unit_us <= 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--workers=", 0) == 0) {
+      if (!ParseValue(argument, options.workers) || options.workers == 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--monte-carlo=", 0) == 0) {
+      if (!ParseValue(argument, options.monte_carlo_trials) || options.monte_carlo_trials == 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--threads=", 0) == 0) {
+      if (!ParseValue(argument, options.threads)) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--convert=", 0) == 0) {
+      options.convert_filepath = argument.substr(argument.find('=') + 1);
+    } else if (argument == "--batch") {
+      options.batch = true;
+    } else if (argument.rfind("--output=", 0) == 0) {
+      options.output_filepath = argument.substr(argument.find('=') + 1);
+    } else if (argument.rfind("--checkpoint=", 0) == 0) {
+      options.checkpoint_filepath = argument.substr(argument.find('=') + 1);
+    } else if (argument.rfind("--checkpoint-interval=", 0) == 0) {
+      if (!ParseValue(argument, options.checkpoint_interval) || options.checkpoint_interval == 0) {
+        return std::nullopt;
+      }
+    } else if (argument.rfind("--cache=", 0) == 0) {
+      options.cache_directory = argument.substr(argument.find('=') + 1);
+    } else if (argument.rfind("--queue-capacity=", 0) == 0) {
+      if (!ParseValue(argument, options.queue_limit.capacity) ||
+          options.queue_limit.capacity == 0) {
+        return std::nullopt;
+      }
+    } else if (argument == "--admission=reject") {
+      options.queue_limit.admission = ps::Admission::kReject;
+    } else if (argument == "--admission=drop-oldest") {
+      options.queue_limit.admission = ps::Admission::kDropOldest;
+    } else if (argument == "--admission=delay") {
+      options.queue_limit.admission = ps::Admission::kDelay;
+    } else if (argument == "--profile") {
+      options.profile = true;
+    } else if (argument == "--sched-trace") {
+      options.sched_trace = true;
+    } else if (argument.rfind("--cpu=", 0) == 0) {
+      std::int64_t cpu{};
+      if (!ParseValue(argument, cpu) || cpu < 0) {
+        return std::nullopt;
+      }
+
+      options.trace_cpu = cpu;
+    } else if (argument == "--arrivals=poisson") {
+      options.workload.arrivals = ps::ArrivalPattern::kPoisson;
+    } else if (argument == "--arrivals=bursty") {
+      options.workload.arrivals = ps::ArrivalPattern::kBursty;
+    } else if (argument == "--bursts=exponential") {
+      options.workload.bursts = ps::BurstDistribution::kExponential;
+    } else if (argument == "--bursts=pareto") {
+      options.workload.bursts = ps::BurstDistribution::kPareto;
+    } else if (argument == "--bursts=bimodal") {
+      options.workload.bursts = ps::BurstDistribution::kBimodal;
+    } else if (argument.rfind("--", 0) == 0) {
+      return std::nullopt;
+    } else if (options.filepath.empty()) {
+      options.filepath = argument;
+      options.batch_inputs.push_back(argument);
+    } else if (options.batch) {
+      options.batch_inputs.push_back(argument);
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (options.batch && options.batch_inputs.empty()) {
+    return std::nullopt;
   }
 
-  std::vector<std::tuple<std::string, ps::Scheduler*>> schedulers = {
-      std::tuple{"FCFS", new ps::FCFSScheduler{processes}},
-      std::tuple{"SJF", new ps::SJFScheduler{processes}},
-      std::tuple{"RR", new ps::RRScheduler{processes, 2}}};
+  if (options.filepath.empty() && options.generate_count == 0 && options.monte_carlo_trials == 0) {
+    return std::nullopt;
+  }
 
-  for (auto& pair : schedulers) {
-    const auto& name{std::get<0>(pair)};
-    const auto& scheduler{std::get<1>(pair)};
+  if (options.trace_cpu && !options.sched_trace) {
+    return std::nullopt;
+  }
 
-    const auto& metrics{scheduler->Start()};
+  // A batch only schedules its inputs and prints their metrics: it writes no
+  // trace or .psb file, and neither generates nor executes workloads.
+  if (options.batch &&
+      (!options.trace_filepath.empty() || options.generate_count > 0 ||
+       options.monte_carlo_trials > 0 || options.execute_unit_us > 0 ||
+       !options.convert_filepath.empty())) {
+    return std::nullopt;
+  }
 
-    std::cout << std::setprecision(1) << std::fixed << name << " " << metrics.tt << " "
-              << metrics.rt << " " << metrics.wt << std::endl;
+  // Batch inputs run concurrently on workers, and checkpoint slots are named
+  // after the algorithm only, so they would share slots.
+  if (options.batch && !options.checkpoint_filepath.empty()) {
+    return std::nullopt;
+  }
 
-    delete scheduler;
+  // A stream keeps no process table, which all of these need.
+  if (options.stream &&
+      (options.generate_count == 0 || options.batch || options.monte_carlo_trials > 0 ||
+       options.execute_unit_us > 0 || options.profile || !options.trace_filepath.empty() ||
+       !options.convert_filepath.empty() || !options.checkpoint_filepath.empty() ||
+       !options.cache_directory.empty() || options.queue_limit.capacity > 0)) {
+    return std::nullopt;
   }
 
-  std::cin.get();
+  return options;
 }
 
 std::vector<ps::Process> ParseFile(const std::filesystem::path& filepath) {
@@ -337,7 +745,7 @@ std::vector<ps::Process> ParseFile(const std::filesystem::path& filepath) {
       token_index++;
     }
 
-    result.push_back({.at = at, .bt = bt, .rbt = bt});
+    result.push_back({.at = at, .bt = bt, .rbt = bt, .id = result.size()});
   }
 
   return result;
@@ -0,0 +1,413 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#include "histogram.h"
+#include "scheduler.h"
+
+// Metrics of a completed run in one separate pass over its result columns,
+// instead of per completion inside the scheduling loop. Built with -mavx2 (or
+// -march=native on a CPU that has it), 32 and 64-bit times are derived and
+// reduced 8 or 4 processes at a time with AVX2; otherwise the same pass runs
+// scalar. Both give identical results.
+namespace ps {
+// Arrival, burst, start and completion columns of `count` records, in separate
+// arrays. A process table is summarized with SummarizeTable instead, which
+// reads each process through its members.
+template <typename Time>
+struct ResultColumns {
+  const Time* at;
+  const Time* bt;
+  const Time* st;
+  const Time* ct;
+  std::size_t count;
+};
+
+// Sum (exact), least and greatest value of one metric.
+struct MetricRange {
+  std::int64_t sum;
+  std::int64_t min{std::numeric_limits<std::int64_t>::max()};
+  std::int64_t max{std::numeric_limits<std::int64_t>::min()};
+
+  void Merge(const MetricRange& other) {
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+};
+
+struct MetricsSummary {
+  std::size_t count;
+  MetricRange tt;
+  MetricRange rt;
+  MetricRange wt;
+
+  ProcessAverageMetrics Average() const {
+    if (count == 0) {
+      return {};
+    }
+
+    const auto divisor{static_cast<double>(count)};
+    return {static_cast<float>(static_cast<double>(tt.sum) / divisor),
+            static_cast<float>(static_cast<double>(rt.sum) / divisor),
+            static_cast<float>(static_cast<double>(wt.sum) / divisor)};
+  }
+};
+
+namespace detail {
+// Records per block: the derived metrics stay in L1 between the passes.
+inline constexpr std::size_t kMetricsBlockSize{1024};
+
+#if defined(__AVX2__)
+namespace avx2 {
+// tt = ct - at, rt = st - at, wt = tt - bt of 8 processes.
+inline void Derive(__m256i at, __m256i bt, __m256i st, __m256i ct, std::int32_t* tt,
+                   std::int32_t* rt, std::int32_t* wt) {
+  const auto turnaround{_mm256_sub_epi32(ct, at)};
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(tt), turnaround);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(rt), _mm256_sub_epi32(st, at));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(wt), _mm256_sub_epi32(turnaround, bt));
+}
+
+inline void Derive(__m256i at, __m256i bt, __m256i st, __m256i ct, std::int64_t* tt,
+                   std::int64_t* rt, std::int64_t* wt) {
+  const auto turnaround{_mm256_sub_epi64(ct, at)};
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(tt), turnaround);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(rt), _mm256_sub_epi64(st, at));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(wt), _mm256_sub_epi64(turnaround, bt));
+}
+
+// Derives the first `count` records (a multiple of 8 or 4 is handled, the
+// number handled is returned).
+inline std::size_t DeriveColumns(const ResultColumns<std::int32_t>& columns, std::size_t first,
+                                 std::size_t count, std::int32_t* tt, std::int32_t* rt,
+                                 std::int32_t* wt) {
+  std::size_t i{};
+
+  for (; i + 8 <= count; i += 8) {
+    const auto load = [&](const std::int32_t* column) {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + first + i));
+    };
+
+    Derive(load(columns.at), load(columns.bt), load(columns.st), load(columns.ct), tt + i,
+           rt + i, wt + i);
+  }
+
+  return i;
+}
+
+inline std::size_t DeriveColumns(const ResultColumns<std::int64_t>& columns, std::size_t first,
+                                 std::size_t count, std::int64_t* tt, std::int64_t* rt,
+                                 std::int64_t* wt) {
+  std::size_t i{};
+
+  for (; i + 4 <= count; i += 4) {
+    const auto load = [&](const std::int64_t* column) {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + first + i));
+    };
+
+    Derive(load(columns.at), load(columns.bt), load(columns.st), load(columns.ct), tt + i,
+           rt + i, wt + i);
+  }
+
+  return i;
+}
+
+inline std::int64_t HorizontalSum(__m256i sums) {
+  const auto halves{_mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1))};
+  return _mm_extract_epi64(halves, 0) + _mm_extract_epi64(halves, 1);
+}
+
+// Reduces the first values (a multiple of 8 or 4) into `range`, returning how
+// many it reduced.
+inline std::size_t Reduce(const std::int32_t* values, std::size_t count, MetricRange& range) {
+  if (count < 8) {
+    return 0;
+  }
+
+  auto sums{_mm256_setzero_si256()};
+  auto minima{_mm256_set1_epi32(std::numeric_limits<std::int32_t>::max())};
+  auto maxima{_mm256_set1_epi32(std::numeric_limits<std::int32_t>::min())};
+
+  std::size_t i{};
+  for (; i + 8 <= count; i += 8) {
+    const auto value{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i))};
+
+    sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(value)));
+    sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(value, 1)));
+    minima = _mm256_min_epi32(minima, value);
+    maxima = _mm256_max_epi32(maxima, value);
+  }
+
+  std::array<std::int32_t, 8> lanes_min{};
+  std::array<std::int32_t, 8> lanes_max{};
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_min.data()), minima);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_max.data()), maxima);
+
+  range.Merge({.sum = HorizontalSum(sums),
+               .min = *std::min_element(lanes_min.begin(), lanes_min.end()),
+               .max = *std::max_element(lanes_max.begin(), lanes_max.end())});
+
+  return i;
+}
+
+inline std::size_t Reduce(const std::int64_t* values, std::size_t count, MetricRange& range) {
+  if (count < 4) {
+    return 0;
+  }
+
+  auto sums{_mm256_setzero_si256()};
+  auto minima{_mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max())};
+  auto maxima{_mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min())};
+
+  std::size_t i{};
+  for (; i + 4 <= count; i += 4) {
+    const auto value{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i))};
+
+    // No 64-bit min/max in AVX2: compare and blend.
+    sums = _mm256_add_epi64(sums, value);
+    minima = _mm256_blendv_epi8(minima, value, _mm256_cmpgt_epi64(minima, value));
+    maxima = _mm256_blendv_epi8(maxima, value, _mm256_cmpgt_epi64(value, maxima));
+  }
+
+  std::array<std::int64_t, 4> lanes_min{};
+  std::array<std::int64_t, 4> lanes_max{};
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_min.data()), minima);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes_max.data()), maxima);
+
+  range.Merge({.sum = HorizontalSum(sums),
+               .min = *std::min_element(lanes_min.begin(), lanes_min.end()),
+               .max = *std::max_element(lanes_max.begin(), lanes_max.end())});
+
+  return i;
+}
+
+// LatencyHistogram::BucketOf of 8 values at a time (negative values count as
+// 0). The bit width comes from the exponent of the value converted to float,
+// less one where the conversion rounded up to the next power of two.
+inline std::size_t Buckets(const std::int32_t* values, std::size_t count,
+                           std::uint32_t* buckets) {
+  constexpr int kSubBucketCount{static_cast<int>(LatencyHistogram::kSubBucketCount)};
+  constexpr int kSubBucketBits{LatencyHistogram::kSubBucketBits};
+  constexpr int kHalfBits{kSubBucketBits - 1};
+
+  std::size_t i{};
+  for (; i + 8 <= count; i += 8) {
+    const auto value{_mm256_max_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), _mm256_setzero_si256())};
+
+    const auto exponent_bits{_mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(value)), 23)};
+    auto exponent{_mm256_sub_epi32(exponent_bits, _mm256_set1_epi32(127))};
+
+    const auto rounded_up{
+        _mm256_cmpeq_epi32(_mm256_srlv_epi32(value, exponent), _mm256_setzero_si256())};
+    exponent = _mm256_add_epi32(exponent, rounded_up);
+
+    // shift = bit width - kSubBucketBits = exponent + 1 - kSubBucketBits
+    const auto shift{_mm256_sub_epi32(exponent, _mm256_set1_epi32(kHalfBits))};
+    const auto large{_mm256_add_epi32(_mm256_slli_epi32(shift, kHalfBits),
+                                      _mm256_srlv_epi32(value, shift))};
+
+    const auto small{_mm256_cmpgt_epi32(_mm256_set1_epi32(kSubBucketCount), value)};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buckets + i),
+                        _mm256_blendv_epi8(large, value, small));
+  }
+
+  return i;
+}
+}  // namespace avx2
+#endif
+
+template <typename Time>
+void DeriveColumns(const ResultColumns<Time>& columns, std::size_t first, std::size_t count,
+                   Time* tt, Time* rt, Time* wt) {
+  std::size_t i{};
+
+#if defined(__AVX2__)
+  if constexpr (std::is_same_v<Time, std::int32_t> || std::is_same_v<Time, std::int64_t>) {
+    i = avx2::DeriveColumns(columns, first, count, tt, rt, wt);
+  }
+#endif
+
+  const auto* at{columns.at + first};
+  const auto* bt{columns.bt + first};
+  const auto* st{columns.st + first};
+  const auto* ct{columns.ct + first};
+
+  for (; i < count; i++) {
+    tt[i] = ct[i] - at[i];
+    rt[i] = st[i] - at[i];
+    wt[i] = tt[i] - bt[i];
+  }
+}
+
+// Reduces `count` values of one metric into `total`, and records them in
+// `histogram` if not null.
+template <typename Time>
+void SummarizeMetric(const Time* values, std::size_t count, MetricRange& total,
+                     LatencyHistogram* histogram, std::uint32_t* buckets) {
+  MetricRange block{};
+  std::size_t i{};
+
+#if defined(__AVX2__)
+  if constexpr (std::is_same_v<Time, std::int32_t> || std::is_same_v<Time, std::int64_t>) {
+    i = avx2::Reduce(values, count, block);
+  }
+#endif
+
+  for (; i < count; i++) {
+    const auto value{static_cast<std::int64_t>(values[i])};
+
+    block.sum += value;
+    block.min = std::min(block.min, value);
+    block.max = std::max(block.max, value);
+  }
+
+  total.Merge(block);
+
+  if (!histogram || count == 0) {
+    return;
+  }
+
+  i = 0;
+
+#if defined(__AVX2__)
+  if constexpr (std::is_same_v<Time, std::int32_t>) {
+    i = avx2::Buckets(values, count, buckets);
+  }
+#endif
+
+  for (; i < count; i++) {
+    const auto value{values[i] < 0 ? 0 : static_cast<std::uint64_t>(values[i])};
+    buckets[i] = static_cast<std::uint32_t>(LatencyHistogram::BucketOf(value));
+  }
+
+  const auto clamp = [](std::int64_t value) {
+    return value < 0 ? std::uint64_t{0} : static_cast<std::uint64_t>(value);
+  };
+
+  histogram->RecordBuckets({buckets, count}, clamp(block.min), clamp(block.max));
+}
+// Derived metrics of one block and the scratch to bucket them.
+template <typename Time>
+struct MetricsBlock {
+  std::array<Time, kMetricsBlockSize> tt;
+  std::array<Time, kMetricsBlockSize> rt;
+  std::array<Time, kMetricsBlockSize> wt;
+  std::array<std::uint32_t, kMetricsBlockSize> buckets;
+};
+
+// Adds the first `count` derived records of `block` to `summary`.
+template <typename Time>
+void SummarizeBlock(MetricsBlock<Time>& block, std::size_t count, MetricsSummary& summary,
+                    ProcessHistograms* histograms) {
+  SummarizeMetric(block.tt.data(), count, summary.tt, histograms ? &histograms->tt : nullptr,
+                  block.buckets.data());
+  SummarizeMetric(block.rt.data(), count, summary.rt, histograms ? &histograms->rt : nullptr,
+                  block.buckets.data());
+  SummarizeMetric(block.wt.data(), count, summary.wt, histograms ? &histograms->wt : nullptr,
+                  block.buckets.data());
+}
+}  // namespace detail
+
+// Derives tt, rt and wt of every record and reduces them to sums, minima and
+// maxima, also recording them in `histograms` if not null. Works block by
+// block, so memory is read once, in order.
+template <typename Time>
+MetricsSummary SummarizeMetrics(const ResultColumns<Time>& columns,
+                                ProcessHistograms* histograms = nullptr) {
+  static_assert(std::is_integral_v<Time> && std::is_signed_v<Time>);
+
+  constexpr auto kBlockSize{detail::kMetricsBlockSize};
+
+  detail::MetricsBlock<Time> block;
+  MetricsSummary summary{.count = columns.count};
+
+  for (std::size_t first = 0; first < columns.count; first += kBlockSize) {
+    const auto count{std::min(kBlockSize, columns.count - first)};
+
+    detail::DeriveColumns(columns, first, count, block.tt.data(), block.rt.data(),
+                          block.wt.data());
+    detail::SummarizeBlock(block, count, summary, histograms);
+  }
+
+  return summary;
+}
+
+// The same over a process table (BasicScheduler::processes()), leaving out
+// dropped processes. The tt, rt and wt of each process are derived and stored
+// in place, in the one pass that reads it, and copied into separate columns
+// for the reductions.
+template <typename Table>
+MetricsSummary SummarizeTable(Table& processes, ProcessHistograms* histograms = nullptr) {
+  using Time = decltype(Table::value_type::at);
+  static_assert(std::is_integral_v<Time> && std::is_signed_v<Time>);
+
+  constexpr auto kBlockSize{detail::kMetricsBlockSize};
+
+  detail::MetricsBlock<Time> block;
+  MetricsSummary summary{};
+
+  for (std::size_t next = 0; next < processes.size();) {
+    std::size_t count{};
+
+    for (; next < processes.size() && count < kBlockSize; next++) {
+      auto& process{processes[next]};
+      if (process.dropped) {
+        continue;
+      }
+
+      process.tt = process.ct - process.at;
+      process.rt = process.st - process.at;
+      process.wt = process.tt - process.bt;
+
+      block.tt[count] = process.tt;
+      block.rt[count] = process.rt;
+      block.wt[count] = process.wt;
+      count++;
+    }
+
+    detail::SummarizeBlock(block, count, summary, histograms);
+    summary.count += count;
+  }
+
+  return summary;
+}
+
+// Drop-in for HistogramMetricsSink that records nothing while scheduling:
+// BasicScheduler then only stores the start and completion of each process
+// and calls Finish once the run completes, which summarizes the whole table
+// in one pass and fills in the tt, rt and wt of its processes.
+struct ColumnarMetricsSink : HistogramMetricsSink {
+  static constexpr bool kDeferred = true;
+
+  template <typename Table>
+  void Finish(Table& processes) {
+    summary = SummarizeTable(processes, &histograms);
+
+    tt = static_cast<double>(summary.tt.sum);
+    rt = static_cast<double>(summary.rt.sum);
+    wt = static_cast<double>(summary.wt.sum);
+    count = summary.count;
+  }
+
+  void Reset() {
+    HistogramMetricsSink::Reset();
+    summary = {};
+  }
+
+  MetricsSummary summary{};
+};
+}  // namespace ps
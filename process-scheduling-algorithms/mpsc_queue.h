@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ps {
+// Bounded lock-free multi-producer single-consumer ring (after Dmitry Vyukov's
+// bounded queue). Producers claim a slot with one compare-and-swap on the tail
+// and publish it through the slot's sequence number; the consumer owns the
+// head and never synchronizes with other consumers, so draining is a plain
+// loop over published slots.
+//
+// Meant as the ingest path of an OnlineScheduler fed by many threads:
+//   producers: while (!arrivals.TryPush(process)) { /* shed or retry */ }
+//   simulation: arrivals.Drain([&](const Process& p) { scheduler.Submit(p); });
+template <typename T>
+class MpscQueue {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit MpscQueue(std::size_t capacity)
+      : capacity_{std::bit_ceil(std::max<std::size_t>(capacity, 2))},
+        mask_{capacity_ - 1},
+        cells_{std::make_unique<Cell[]>(capacity_)} {
+    for (std::size_t i = 0; i < capacity_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Any thread. Fails, without blocking, when the ring is full.
+  bool TryPush(const T& value) {
+    auto position{tail_.load(std::memory_order_relaxed)};
+    Cell* cell{};
+
+    while (true) {
+      cell = &cells_[position & mask_];
+
+      const auto sequence{cell->sequence.load(std::memory_order_acquire)};
+      const auto distance{static_cast<std::intptr_t>(sequence) -
+                          static_cast<std::intptr_t>(position)};
+
+      if (distance == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (distance < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Consumer thread only. Hands up to `max_count` published values to
+  // `consume`, in push order per producer, and returns how many it handed.
+  template <typename Consumer>
+  std::size_t Drain(Consumer&& consume, std::size_t max_count = SIZE_MAX) {
+    std::size_t drained{};
+
+    while (drained < max_count) {
+      auto& cell{cells_[head_ & mask_]};
+
+      if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+        break;
+      }
+
+      consume(static_cast<const T&>(cell.value));
+      cell.sequence.store(head_ + capacity_, std::memory_order_release);
+
+      head_++;
+      drained++;
+    }
+
+    return drained;
+  }
+
+  std::size_t capacity() const { return capacity_; }
+
+ private:
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  // Producers and the consumer write these from different cores.
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{};
+  alignas(kCacheLineSize) std::size_t head_{};
+};
+}  // namespace ps
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "ready_queue.h"
+#include "scheduler.h"
+
+namespace ps {
+template <typename Time>
+struct OnlineSnapshot {
+  Time clock;
+  std::optional<std::size_t> running;  // Id of the process on the CPU, if any
+  Time running_remaining;              // Its remaining burst time
+  std::size_t ready;                   // Processes waiting in the ready queue
+  std::size_t pending;                 // Submitted processes that have not arrived yet
+  std::size_t completed;
+  ProcessAverageMetrics averages;      // Of the completed processes
+};
+
+// Incremental counterpart of BasicScheduler: processes are submitted while the
+// simulation runs and the clock only moves when asked to, so a caller can keep
+// a live model of a system and fork copies of it for what-if decisions.
+//
+// Submit and every event processed by AdvanceTo cost O(log n) in the number of
+// live (pending, ready or running) processes; Snapshot is O(1). Slots of
+// completed processes are reused, so memory is bounded by the live processes
+// however many go through the scheduler. With the same inputs, the results
+// match BasicScheduler::Start.
+template <typename Policy, template <typename> class Queue, typename Time = int,
+          typename Sink = HistogramMetricsSink>
+class OnlineScheduler {
+ public:
+  using ProcessType = BasicProcess<Time>;
+
+  explicit OnlineScheduler(Policy policy = {}) : policy_{policy} { RebindQueues(); }
+
+  OnlineScheduler(const OnlineScheduler& other)
+      : processes_{other.processes_},
+        free_slots_{other.free_slots_},
+        pending_{other.pending_},
+        ready_{other.ready_},
+        policy_{other.policy_},
+        sink_{other.sink_},
+        clock_{other.clock_},
+        running_{other.running_},
+        slice_start_{other.slice_start_},
+        slice_end_{other.slice_end_},
+        completed_{other.completed_} {
+    RebindQueues();
+  }
+
+  OnlineScheduler& operator=(const OnlineScheduler& other) {
+    if (this != &other) {
+      processes_ = other.processes_;
+      free_slots_ = other.free_slots_;
+      pending_ = other.pending_;
+      ready_ = other.ready_;
+      policy_ = other.policy_;
+      sink_ = other.sink_;
+      clock_ = other.clock_;
+      running_ = other.running_;
+      slice_start_ = other.slice_start_;
+      slice_end_ = other.slice_end_;
+      completed_ = other.completed_;
+
+      RebindQueues();
+    }
+
+    return *this;
+  }
+
+  // Only `at`, `bt` and `id` are used. A process submitted with an arrival
+  // time already behind the clock is ready right away, but its metrics are
+  // still measured from `at`.
+  template <typename InputTime>
+  void Submit(const BasicProcess<InputTime>& process) {
+    std::size_t index{processes_.size()};
+
+    if (free_slots_.empty()) {
+      processes_.emplace_back();
+    } else {
+      index = free_slots_.back();
+      free_slots_.pop_back();
+    }
+
+    processes_[index] = {.at = static_cast<Time>(process.at),
+                         .bt = static_cast<Time>(process.bt),
+                         .rbt = static_cast<Time>(process.bt),
+                         .id = process.id};
+
+    pending_.Push(index);
+  }
+
+  // Processes every event that happens before `time` and leaves the clock
+  // there. Dispatches and slice ends at `time` itself wait for the next call,
+  // so processes arriving at `time` can still be submitted and take part in
+  // them. Moving backwards does nothing.
+  void AdvanceTo(Time time) {
+    while (Step(time)) {
+    }
+
+    clock_ = std::max(clock_, time);
+  }
+
+  // Runs every submitted process to completion.
+  void Drain() {
+    while (Step(std::numeric_limits<Time>::max())) {
+    }
+  }
+
+  OnlineSnapshot<Time> Snapshot() const {
+    OnlineSnapshot<Time> snapshot{.clock = clock_,
+                                  .ready = ready_.size(),
+                                  .pending = pending_.size(),
+                                  .completed = completed_,
+                                  .averages = sink_.Average()};
+
+    if (running_) {
+      const auto& process{processes_[*running_]};
+
+      snapshot.running = process.id;
+      snapshot.running_remaining = process.rbt - (clock_ - slice_start_);
+    }
+
+    return snapshot;
+  }
+
+  const Sink& metrics() const { return sink_; }
+
+  Time clock() const { return clock_; }
+
+ private:
+  using OrderType = ProcessOrder<Policy, ProcessType>;
+  using ArrivalOrderType = ProcessOrder<FCFSPolicy, ProcessType>;
+
+  void RebindQueues() {
+    pending_.set_order(ArrivalOrderType{&processes_});
+    ready_.set_order(OrderType{&processes_});
+  }
+
+  // Processes the next event if it happens before `limit`.
+  bool Step(Time limit) {
+    if (running_) {
+      if (slice_end_ >= limit) {
+        return false;
+      }
+
+      EndSlice();
+      return true;
+    }
+
+    if (clock_ >= limit) {
+      return false;
+    }
+
+    AdmitArrivals();
+
+    if (!ready_.empty()) {
+      Dispatch();
+      return true;
+    }
+
+    if (pending_.empty() || processes_[pending_.Top()].at >= limit) {
+      return false;
+    }
+
+    clock_ = processes_[pending_.Top()].at;
+    return true;
+  }
+
+  void AdmitArrivals() {
+    while (!pending_.empty() && processes_[pending_.Top()].at <= clock_) {
+      ready_.Push(pending_.Pop());
+    }
+  }
+
+  void Dispatch() {
+    const auto index{ready_.Pop()};
+    auto& process{processes_[index]};
+
+    if (process.rbt == process.bt) {
+      process.st = clock_;
+    }
+
+    running_ = index;
+    slice_start_ = clock_;
+    slice_end_ = clock_ + policy_.Slice(process.rbt);
+  }
+
+  void EndSlice() {
+    const auto index{*running_};
+    auto& process{processes_[index]};
+
+    running_.reset();
+
+    process.rbt -= slice_end_ - slice_start_;
+    clock_ = slice_end_;
+
+    if (process.rbt > 0) {
+      AdmitArrivals();
+      ready_.Push(index);
+
+      return;
+    }
+
+    process.ct = clock_;
+    process.tt = process.ct - process.at;
+    process.rt = process.st - process.at;
+    process.wt = process.tt - process.bt;
+    process.finished = true;
+
+    sink_.Record(process);
+    completed_++;
+
+    free_slots_.push_back(index);
+  }
+
+  std::vector<ProcessType> processes_{};
+  std::vector<std::size_t> free_slots_{};
+
+  HeapQueue<ArrivalOrderType> pending_{};
+  Queue<OrderType> ready_{};
+
+  Policy policy_;
+  Sink sink_{};
+
+  Time clock_{};
+  std::optional<std::size_t> running_{};
+  Time slice_start_{};
+  Time slice_end_{};
+  std::size_t completed_{};
+};
+
+using OnlineFCFSScheduler = OnlineScheduler<FCFSPolicy, FifoQueue>;
+using OnlineSJFScheduler = OnlineScheduler<SJFPolicy, HeapQueue>;
+using OnlineRRScheduler = OnlineScheduler<RRPolicy, FifoQueue>;
+}  // namespace ps
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace ps {
+// Ready queues hold indexes into a scheduler's process table. `Order` tells
+// whether the process at one index should run before the one at another; it is
+// only consulted by the queues that are not first-in first-out.
+//
+// Both take the allocator of their index storage, so a scheduler can place it
+// in a per-run arena (see arena.h).
+//
+// PopLowest removes the lowest queued index, which is the earliest arrival in a
+// scheduler's table; it is O(n), for shedding load from bounded queues.
+//
+// For checkpoints, segments() exposes the queued indexes in place (as at most
+// two contiguous runs) and Assign restores a queue from what segments() gave.
+
+// First-in first-out ring buffer. Every process is queued at most once at a
+// time, so Reserve(process count) makes Push allocation free.
+template <typename Order, typename Allocator = std::allocator<std::size_t>>
+class FifoQueue {
+ public:
+  constexpr FifoQueue() = default;
+  constexpr explicit FifoQueue(Order, const Allocator& allocator = {}) : slots_(allocator) {}
+
+  constexpr void set_order(Order) {}
+
+  constexpr void Reserve(std::size_t capacity) {
+    slots_.assign(std::max<std::size_t>(capacity, 1), 0);
+    head_ = 0;
+    size_ = 0;
+  }
+
+  constexpr void Push(std::size_t index) {
+    if (size_ == slots_.size()) {
+      Grow();
+    }
+
+    auto tail{head_ + size_};
+    if (tail >= slots_.size()) {
+      tail -= slots_.size();
+    }
+
+    slots_[tail] = index;
+    size_++;
+  }
+
+  constexpr std::size_t Pop() {
+    const auto index{slots_[head_]};
+
+    if (++head_ == slots_.size()) {
+      head_ = 0;
+    }
+
+    size_--;
+    return index;
+  }
+
+  constexpr std::size_t Top() const { return slots_[head_]; }
+
+  // The others keep their order.
+  constexpr std::size_t PopLowest() {
+    const auto slot = [this](std::size_t position) -> std::size_t& {
+      return slots_[(head_ + position) % slots_.size()];
+    };
+
+    std::size_t lowest{};
+    for (std::size_t position = 1; position < size_; position++) {
+      if (slot(position) < slot(lowest)) {
+        lowest = position;
+      }
+    }
+
+    const auto index{slot(lowest)};
+    for (auto position = lowest; position + 1 < size_; position++) {
+      slot(position) = slot(position + 1);
+    }
+
+    size_--;
+    return index;
+  }
+
+  constexpr bool empty() const { return size_ == 0; }
+  constexpr std::size_t size() const { return size_; }
+
+  // Queued indexes in pop order.
+  constexpr std::array<std::span<const std::size_t>, 2> segments() const {
+    const std::span<const std::size_t> slots{slots_};
+    const auto first{std::min(size_, slots_.size() - head_)};
+
+    return {slots.subspan(head_, first), slots.first(size_ - first)};
+  }
+
+  constexpr void Assign(std::span<const std::size_t> indexes) {
+    Reserve(std::max(slots_.size(), indexes.size()));
+
+    for (const auto index : indexes) {
+      Push(index);
+    }
+  }
+
+ private:
+  constexpr void Grow() {
+    std::vector<std::size_t, Allocator> slots(std::max<std::size_t>(slots_.size() * 2, 1),
+                                              slots_.get_allocator());
+
+    for (std::size_t i = 0; i < size_; i++) {
+      slots[i] = slots_[(head_ + i) % slots_.size()];
+    }
+
+    slots_.swap(slots);
+    head_ = 0;
+  }
+
+  std::vector<std::size_t, Allocator> slots_{};
+  std::size_t head_{};
+  std::size_t size_{};
+};
+
+// Binary heap popping the index that `Order` puts first.
+template <typename Order, typename Allocator = std::allocator<std::size_t>>
+class HeapQueue {
+ public:
+  constexpr HeapQueue() = default;
+  constexpr explicit HeapQueue(Order order, const Allocator& allocator = {})
+      : heap_(allocator), order_{order} {}
+
+  // Only valid while the queue is empty or `order` ranks indexes as before.
+  constexpr void set_order(Order order) { order_ = order; }
+
+  constexpr void Reserve(std::size_t capacity) {
+    heap_.clear();
+    heap_.reserve(capacity);
+  }
+
+  constexpr void Push(std::size_t index) {
+    heap_.push_back(index);
+    std::push_heap(heap_.begin(), heap_.end(), After{order_});
+  }
+
+  constexpr std::size_t Pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), After{order_});
+
+    const auto index{heap_.back()};
+    heap_.pop_back();
+
+    return index;
+  }
+
+  constexpr std::size_t Top() const { return heap_.front(); }
+
+  constexpr std::size_t PopLowest() {
+    const auto lowest{std::min_element(heap_.begin(), heap_.end())};
+    const auto index{*lowest};
+
+    *lowest = heap_.back();
+    heap_.pop_back();
+    std::make_heap(heap_.begin(), heap_.end(), After{order_});
+
+    return index;
+  }
+
+  constexpr bool empty() const { return heap_.empty(); }
+  constexpr std::size_t size() const { return heap_.size(); }
+
+  // The heap array, in storage order.
+  constexpr std::array<std::span<const std::size_t>, 2> segments() const { return {heap_, {}}; }
+
+  // `indexes` must already be a heap under the queue's order.
+  constexpr void Assign(std::span<const std::size_t> indexes) {
+    heap_.assign(indexes.begin(), indexes.end());
+  }
+
+ private:
+  // std::*_heap keep the greatest element on top.
+  struct After {
+    Order order;
+
+    constexpr bool operator()(std::size_t lhs, std::size_t rhs) const { return order(rhs, lhs); }
+  };
+
+  std::vector<std::size_t, Allocator> heap_{};
+  Order order_{};
+};
+}  // namespace ps
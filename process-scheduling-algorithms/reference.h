@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "admission.h"
+#include "scheduler.h"
+
+// The original straightforward schedulers, kept as oracles for the optimized
+// BasicScheduler family: a linear rescan per dispatch for SJF, a rescan of
+// every process after each RR slice and one clock tick per idle time unit.
+// They are deliberately slow and are only meant to be diffed against (see
+// differential.cc). The dispatch logic is the original one; the changes are a
+// stable sort, so arrival ties keep input order like in FCFSPolicy, RR keeping
+// its queued flags in a local vector<bool> instead of on the processes, the
+// constructor clearing rbt, finished and dropped so any table can be passed
+// in, and access to the per-process results.
+//
+// BoundedScheduler is newer: the same plain approach for bounded ready queues
+// (see QueueLimit), which the originals never had.
+namespace ps::reference {
+class Scheduler {
+ public:
+  explicit Scheduler(std::vector<Process> processes)
+      : processes_(std::move(processes)), processes_count_{processes_.size()} {
+    for (auto& process : processes_) {
+      process.rbt = process.bt;
+      process.finished = false;
+      process.dropped = false;
+    }
+  }
+
+  virtual ~Scheduler() = default;
+
+  virtual ProcessAverageMetrics Start() = 0;
+
+  // Processes with the results of the last Start.
+  const std::vector<Process>& processes() const { return processes_; }
+
+ protected:
+  void SortArrivalTimeAsceding() {
+    auto comparer = [](const Process& lhs, const Process& rhs) {
+      return lhs.at < rhs.at;
+    };
+
+    std::stable_sort(processes_.begin(), processes_.end(), comparer);
+  }
+
+  std::vector<Process> processes_;
+  std::size_t processes_count_;
+};
+
+class FCFSScheduler : public Scheduler {
+ public:
+  explicit FCFSScheduler(const std::vector<Process>& processes) : Scheduler(processes) {}
+
+  ~FCFSScheduler() override = default;
+
+  ProcessAverageMetrics Start() override {
+    ProcessAverageMetrics metrics{};
+
+    SortArrivalTimeAsceding();
+
+    for (std::size_t i = 0; i < processes_count_; i++) {
+      auto& process{processes_[i]};
+
+      process.st = i == 0 ? process.at : std::max(process.at, processes_[i - 1].ct);
+      process.ct = process.st + process.bt;
+
+      process.tt = process.ct - process.at;
+      process.rt = process.st - process.at;
+      process.wt = process.tt - process.bt;
+
+      metrics.tt += static_cast<float>(process.tt);
+      metrics.rt += static_cast<float>(process.rt);
+      metrics.wt += static_cast<float>(process.wt);
+    }
+
+    metrics.tt /= static_cast<float>(processes_count_);
+    metrics.rt /= static_cast<float>(processes_count_);
+    metrics.wt /= static_cast<float>(processes_count_);
+
+    return metrics;
+  }
+};
+
+class SJFScheduler : public Scheduler {
+ public:
+  explicit SJFScheduler(const std::vector<Process>& processes) : Scheduler(processes) {}
+
+  ~SJFScheduler() override = default;
+
+  ProcessAverageMetrics Start() override {
+    ProcessAverageMetrics metrics{};
+
+    int time_passed{};
+
+    std::size_t finished_count{};
+    while (finished_count < processes_count_) {
+      Process* pProcess{};
+
+      int bt_threshold = std::numeric_limits<int>::max();
+
+      for (auto& process : processes_) {
+        if (process.finished || process.at > time_passed) {
+          continue;
+        }
+
+        bool found{process.bt < bt_threshold};
+        if (process.bt == bt_threshold && pProcess) {
+          found = process.at < pProcess->at;
+        }
+
+        if (found) {
+          bt_threshold = process.bt;
+          pProcess = &process;
+        }
+      }
+
+      if (!pProcess) {
+        time_passed++;
+        continue;
+      }
+
+      pProcess->st = time_passed;
+      pProcess->ct = pProcess->st + pProcess->bt;
+
+      pProcess->tt = pProcess->ct - pProcess->at;
+      pProcess->rt = pProcess->st - pProcess->at;
+      pProcess->wt = pProcess->tt - pProcess->bt;
+
+      time_passed = pProcess->ct;
+
+      metrics.tt += static_cast<float>(pProcess->tt);
+      metrics.rt += static_cast<float>(pProcess->rt);
+      metrics.wt += static_cast<float>(pProcess->wt);
+
+      pProcess->finished = true;
+      finished_count++;
+    }
+
+    metrics.tt /= static_cast<float>(processes_count_);
+    metrics.rt /= static_cast<float>(processes_count_);
+    metrics.wt /= static_cast<float>(processes_count_);
+
+    return metrics;
+  }
+};
+
+class RRScheduler : public Scheduler {
+ public:
+  explicit RRScheduler(const std::vector<Process>& processes, int quantum)
+      : Scheduler(processes), quantum_{quantum} {}
+
+  ~RRScheduler() override = default;
+
+  ProcessAverageMetrics Start() override {
+    SortArrivalTimeAsceding();
+
+    ProcessAverageMetrics metrics{};
+
+    int time_passed{};
+
+    std::queue<std::size_t> ready_indexes_queue{};
+    std::vector<bool> queued(processes_count_);
+
+    ready_indexes_queue.push(0);
+
+    std::size_t finished_count{};
+    while (finished_count < processes_count_) {
+      const auto curr_index{ready_indexes_queue.front()};
+      auto& curr{processes_[curr_index]};
+
+      ready_indexes_queue.pop();
+
+      if (curr.rbt == curr.bt) {
+        curr.st = std::max(time_passed, curr.at);
+        time_passed = curr.st;
+      }
+
+      if (curr.rbt - quantum_ > 0) {
+        curr.rbt -= quantum_;
+        time_passed += quantum_;
+      } else {
+        time_passed += curr.rbt;
+
+        curr.ct = time_passed;
+        curr.tt = curr.ct - curr.at;
+        curr.rt = curr.st - curr.at;
+        curr.wt = curr.tt - curr.bt;
+
+        metrics.tt += static_cast<float>(curr.tt);
+        metrics.rt += static_cast<float>(curr.rt);
+        metrics.wt += static_cast<float>(curr.wt);
+
+        curr.rbt = 0;
+        curr.finished = true;
+
+        finished_count++;
+      }
+
+      for (std::size_t next_index = 1; next_index < processes_count_; next_index++) {
+        auto& next{processes_[next_index]};
+
+        if (queued[next_index] || next.finished) {
+          continue;
+        }
+
+        if (next.at <= time_passed) {
+          ready_indexes_queue.push(next_index);
+          queued[next_index] = true;
+        }
+      }
+
+      if (!curr.finished) {
+        ready_indexes_queue.push(curr_index);
+      }
+
+      if (ready_indexes_queue.empty()) {
+        for (std::size_t next_index = 1; next_index < processes_count_; next_index++) {
+          if (processes_[next_index].finished) {
+            continue;
+          }
+
+          ready_indexes_queue.push(next_index);
+          queued[next_index] = true;
+
+          break;
+        }
+      }
+    }
+
+    metrics.tt /= static_cast<float>(processes_count_);
+    metrics.rt /= static_cast<float>(processes_count_);
+    metrics.wt /= static_cast<float>(processes_count_);
+
+    return metrics;
+  }
+
+ private:
+  int quantum_;
+};
+
+// Any policy behind a bounded ready queue, with the ready processes in a plain
+// vector in the order they were queued: the first one runs next, or, when
+// `ordered` (a heap queue, like SJF), the first one by Policy::Before. Averages
+// are over the completed processes; dropped ones are marked.
+template <typename Policy>
+class BoundedScheduler : public Scheduler {
+ public:
+  BoundedScheduler(const std::vector<Process>& processes, QueueLimit limit, bool ordered,
+                   Policy policy = {})
+      : Scheduler(processes), limit_{limit}, ordered_{ordered}, policy_{std::move(policy)} {}
+
+  ~BoundedScheduler() override = default;
+
+  ProcessAverageMetrics Start() override {
+    SortArrivalTimeAsceding();
+
+    ProcessAverageMetrics metrics{};
+
+    int time_passed{};
+
+    std::vector<std::size_t> ready{};
+    std::size_t next_arrival{};
+    std::size_t finished_count{};
+    std::size_t completed_count{};
+
+    // `reserved` slots are kept for the process that was just preempted.
+    const auto admit = [&](std::size_t reserved) {
+      for (; next_arrival < processes_count_ && processes_[next_arrival].at <= time_passed;
+           next_arrival++) {
+        const bool full{limit_.capacity > 0 && ready.size() + reserved >= limit_.capacity};
+
+        if (full && limit_.admission == Admission::kDelay) {
+          return;
+        }
+
+        if (full && (limit_.admission == Admission::kReject || ready.empty())) {
+          processes_[next_arrival].dropped = true;
+          finished_count++;
+          continue;
+        }
+
+        if (full) {
+          const auto oldest{std::min_element(ready.begin(), ready.end())};
+
+          processes_[*oldest].dropped = true;
+          finished_count++;
+          ready.erase(oldest);
+        }
+
+        ready.push_back(next_arrival);
+      }
+    };
+
+    while (finished_count < processes_count_) {
+      admit(0);
+
+      if (ready.empty()) {
+        if (finished_count == processes_count_) {
+          break;
+        }
+
+        time_passed = processes_[next_arrival].at;
+        continue;
+      }
+
+      auto next{ready.begin()};
+      if (ordered_) {
+        for (auto candidate{ready.begin()}; candidate != ready.end(); candidate++) {
+          if (Policy::Before(processes_[*candidate], processes_[*next])) {
+            next = candidate;
+          }
+        }
+      }
+
+      const auto curr_index{*next};
+      auto& curr{processes_[curr_index]};
+
+      ready.erase(next);
+
+      if (curr.rbt == curr.bt) {
+        curr.st = time_passed;
+      }
+
+      const int slice{policy_.Slice(curr.rbt)};
+
+      time_passed += slice;
+      curr.rbt -= slice;
+
+      if (curr.rbt > 0) {
+        admit(1);
+        ready.push_back(curr_index);
+        continue;
+      }
+
+      curr.ct = time_passed;
+      curr.tt = curr.ct - curr.at;
+      curr.rt = curr.st - curr.at;
+      curr.wt = curr.tt - curr.bt;
+
+      metrics.tt += static_cast<float>(curr.tt);
+      metrics.rt += static_cast<float>(curr.rt);
+      metrics.wt += static_cast<float>(curr.wt);
+
+      curr.finished = true;
+
+      finished_count++;
+      completed_count++;
+    }
+
+    if (completed_count > 0) {
+      metrics.tt /= static_cast<float>(completed_count);
+      metrics.rt /= static_cast<float>(completed_count);
+      metrics.wt /= static_cast<float>(completed_count);
+    }
+
+    return metrics;
+  }
+
+ private:
+  QueueLimit limit_;
+  bool ordered_;
+  Policy policy_;
+};
+}  // namespace ps::reference
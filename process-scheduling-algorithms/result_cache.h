@@ -0,0 +1,176 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "scheduler.h"
+
+namespace ps {
+// What a result depends on: the workload (see HashWorkload), the algorithm and
+// its parameters (see PolicyParameters).
+struct ResultKey {
+  std::uint64_t workload_hash;
+  std::uint64_t process_count;
+  std::string_view algorithm;  // At most 15 characters
+  std::uint64_t parameters;
+};
+
+struct CachedResult {
+  ProcessAverageMetrics metrics;
+  ProcessHistograms histograms;  // Any percentile can be read back
+};
+
+// Hash of a policy's parameters (the RR quantum), 0 for policies without any.
+template <typename Policy>
+std::uint64_t PolicyParameters(const Policy& policy) {
+  static_assert(std::is_trivially_copyable_v<Policy>);
+
+  if constexpr (std::is_empty_v<Policy>) {
+    return 0;
+  } else {
+    std::array<unsigned char, sizeof(Policy)> bytes{};
+    std::memcpy(bytes.data(), &policy, sizeof(Policy));
+
+    // FNV-1a; policies are a few bytes.
+    std::uint64_t hash{0xcbf29ce484222325ULL};
+    for (const auto byte : bytes) {
+      hash = (hash ^ byte) * 0x100000001b3ULL;
+    }
+
+    return hash;
+  }
+}
+
+// On-disk cache of scheduler results, one file per key in `directory`, named
+// after a hash of the key:
+//
+//   ResultCache cache{"results"};
+//   if (auto cached{cache.Find(key)}) { ... } else { ...; cache.Store(key, result); }
+//
+// Every file also holds the full key and the kSchedulerVersion it was computed
+// with, so a hash collision or a result of an older scheduler is a miss, and
+// the next Store replaces it. Stores are written to a temporary file and
+// renamed, so concurrent runs sharing a directory never read a partial file.
+class ResultCache {
+ public:
+  explicit ResultCache(std::filesystem::path directory) : directory_{std::move(directory)} {}
+
+  std::optional<CachedResult> Find(const ResultKey& key) const {
+    std::ifstream file{FilePath(key), std::ios::binary};
+
+    const auto expected{MakeHeader(key)};
+    Header header{};
+    CachedResult result{};
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(&header, &expected, sizeof(header)) != 0 ||
+        !file.read(reinterpret_cast<char*>(&result), sizeof(result))) {
+      return std::nullopt;
+    }
+
+    return result;
+  }
+
+  // Returns false if the result could not be written; the cache is only an
+  // optimization, so callers may ignore it.
+  bool Store(const ResultKey& key, const CachedResult& result) const {
+    std::error_code error{};
+    std::filesystem::create_directories(directory_, error);
+
+    static std::atomic<std::uint64_t> next_temporary{};
+
+    const auto filepath{FilePath(key)};
+    auto temporary_filepath{filepath};
+    temporary_filepath += ".tmp." + std::to_string(getpid()) + "." +
+                          std::to_string(next_temporary++);
+
+    {
+      std::ofstream file{temporary_filepath, std::ios::binary | std::ios::trunc};
+      const auto header{MakeHeader(key)};
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(&result), sizeof(result));
+
+      if (!file.flush()) {
+        std::filesystem::remove(temporary_filepath, error);
+        return false;
+      }
+    }
+
+    std::filesystem::rename(temporary_filepath, filepath, error);
+    if (error) {
+      std::filesystem::remove(temporary_filepath, error);
+      return false;
+    }
+
+    return true;
+  }
+
+ private:
+  struct Header {
+    static constexpr std::array<char, 8> kMagic{'P', 'S', 'R', 'E', 'S', 'U', 'L', 'T'};
+    static constexpr std::uint32_t kVersion = 1;  // Of this file format
+
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t scheduler_version;
+    std::uint64_t result_size;
+    std::uint64_t workload_hash;
+    std::uint64_t process_count;
+    std::uint64_t parameters;
+    std::array<char, 16> algorithm;
+  };
+
+  static_assert(std::has_unique_object_representations_v<Header>);
+  static_assert(std::is_trivially_copyable_v<CachedResult>);
+
+  static Header MakeHeader(const ResultKey& key) {
+    Header header{.magic = Header::kMagic,
+                  .version = Header::kVersion,
+                  .scheduler_version = kSchedulerVersion,
+                  .result_size = sizeof(CachedResult),
+                  .workload_hash = key.workload_hash,
+                  .process_count = key.process_count,
+                  .parameters = key.parameters,
+                  .algorithm = {}};
+
+    key.algorithm.copy(header.algorithm.data(), header.algorithm.size() - 1);
+    return header;
+  }
+
+  // The scheduler version is left out of the name, so a newer scheduler
+  // overwrites the stale file instead of adding one.
+  std::filesystem::path FilePath(const ResultKey& key) const {
+    std::uint64_t hash{key.workload_hash};
+    const auto combine = [&hash](std::uint64_t value) {
+      hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+
+    combine(key.process_count);
+    combine(key.parameters);
+    for (const auto character : key.algorithm) {
+      combine(static_cast<unsigned char>(character));
+    }
+
+    std::array<char, 17> name{};
+    std::snprintf(name.data(), name.size(), "%016llx", static_cast<unsigned long long>(hash));
+
+    return directory_ / (std::string{name.data()} + ".psr");
+  }
+
+  std::filesystem::path directory_;
+};
+}  // namespace ps
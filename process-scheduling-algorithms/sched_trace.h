@@ -0,0 +1,436 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "scheduler.h"
+
+namespace ps {
+// Rebuilds CPU bursts from the text output of `perf sched script` or of the
+// ftrace sched_switch/sched_wakeup events (trace_pipe, trace-cmd report). The
+// event fields are read either as raw key=value pairs (trace_pipe, older perf)
+// or in the compact form of the sched plugins (trace-cmd, current perf):
+//
+//   bash  1234 [002] 5891.123456: sched:sched_wakeup: comm=bash pid=1234 ...
+//   <idle>-0 [002] d..3 5891.123470: sched_switch: prev_comm=swapper/2
+//       prev_pid=0 prev_prio=120 prev_state=R ==> next_comm=bash next_pid=1234 ...
+//
+//   bash  1234 [002] 5891.123456: sched:sched_wakeup: bash:1234 [120] <CPU:002>
+//   swapper 0 [002] 5891.123470: sched:sched_switch: swapper/2:0 [120] R ==>
+//       bash:1234 [120]
+//
+// A burst starts when a task is woken up (or first switched in without a
+// wakeup) and ends when it is switched out in a blocked state; being switched
+// out while still runnable (prev_state R) is a preemption and the burst goes
+// on. Each burst becomes a process with at = start and bt = CPU time actually
+// received, both in microseconds from the first event. The kernel's own
+// decisions are kept in st (first switch-in) and ct (switch-out), so tt, rt
+// and wt describe what really happened and can be compared with the
+// counterfactual policies. Idle tasks (pid 0) are ignored, and bursts still
+// open at the end of the trace are dropped.
+//
+// Bursts of every CPU are read by default, as if they had all run on one. With
+// a CPU given, only that CPU's bursts are read: the switches it ran and the
+// wakeups that target it. A burst that migrates before it blocks ends on
+// another CPU, so it is dropped like a burst still open at the end.
+//
+// Events are expected in time order, as perf and the ftrace trace file merge
+// the per-CPU buffers. An event older than one already read (per-CPU
+// trace_pipe readers interleaved, say) is skipped and counted, since deriving
+// from it could give negative bursts or arrivals.
+//
+// With Time = int, times pass INT_MAX after about 35 minutes of trace; the
+// reader then stops and reports it rather than saturate or wrap.
+template <typename Time = int>
+class BasicSchedTraceReader {
+ public:
+  using ProcessType = BasicProcess<Time>;
+
+  explicit BasicSchedTraceReader(const std::filesystem::path& filepath,
+                                 std::optional<std::int64_t> cpu = std::nullopt)
+      : file_stream_{filepath, std::ios::in}, cpu_{cpu} {}
+
+  bool is_open() const { return file_stream_.is_open(); }
+
+  // Reads until the next burst ends and stores it in `process`. Bursts come
+  // out in the order they end, not in arrival order. Returns false at the end
+  // of the trace, or at the first burst with a time that does not fit.
+  bool Next(ProcessType& process) {
+    while (!overflowed_ && std::getline(file_stream_, line_)) {
+      if (ParseLine(line_, process)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Lines that looked like sched events but could not be parsed.
+  std::size_t skipped() const { return skipped_; }
+
+  // Events skipped for being older than one read before them.
+  std::size_t out_of_order() const { return out_of_order_; }
+
+  // Whether reading stopped at a time past the range of Time.
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  struct Task {
+    std::int64_t arrival;
+    std::int64_t first_run{-1};
+    std::int64_t on_cpu_since{-1};
+    std::int64_t cpu{};
+  };
+
+  bool ParseLine(std::string_view line, ProcessType& process) {
+    auto event{line.find("sched_switch:")};
+    const bool is_switch{event != std::string_view::npos};
+
+    if (!is_switch) {
+      event = line.find("sched_wakeup");
+    }
+
+    if (event == std::string_view::npos) {
+      return false;
+    }
+
+    // Past the event name ("sched_wakeup:", "sched_wakeup_new:"...).
+    const auto name_end{line.find(':', event)};
+    if (name_end == std::string_view::npos) {
+      skipped_++;
+      return false;
+    }
+
+    const auto fields{line.substr(name_end + 1)};
+
+    if (cpu_ && is_switch) {
+      const auto cpu{ParseCpu(line.substr(0, event))};
+      if (!cpu) {
+        skipped_++;
+        return false;
+      }
+
+      if (*cpu != *cpu_) {
+        return false;
+      }
+    }
+
+    const auto timestamp{ParseTimestamp(line)};
+    if (!timestamp) {
+      skipped_++;
+      return false;
+    }
+
+    if (!origin_) {
+      origin_ = *timestamp;
+    }
+
+    const auto time{*timestamp - *origin_};
+
+    if (time < latest_) {
+      out_of_order_++;
+      return false;
+    }
+
+    latest_ = time;
+
+    if (!is_switch) {
+      const auto pid{fields.find("pid=") != std::string_view::npos ? ParseField(fields, "pid=")
+                                                                     : TaskPid(fields)};
+      if (!pid) {
+        skipped_++;
+        return false;
+      }
+
+      if (*pid == 0) {
+        return false;
+      }
+
+      const auto task_it{tasks_.find(*pid)};
+
+      if (cpu_ && task_it != tasks_.end() && task_it->second.on_cpu_since < 0) {
+        auto& task{task_it->second};
+
+        // Woken onto another CPU: the burst queued here runs there.
+        if (const auto target{TargetCpu(fields)}; target && *target != *cpu_) {
+          tasks_.erase(task_it);
+          return false;
+        }
+
+        // Ran here, then blocked elsewhere: this is a new burst.
+        if (task.first_run >= 0) {
+          task = Task{.arrival = time};
+        }
+
+        return false;
+      }
+
+      if (task_it == tasks_.end()) {
+        if (const auto target{TargetCpu(fields)}; !cpu_ || !target || *target == *cpu_) {
+          tasks_.emplace(*pid, Task{.arrival = time});
+        }
+      }
+
+      return false;
+    }
+
+    std::optional<std::int64_t> prev_pid{};
+    std::optional<std::int64_t> next_pid{};
+    std::string_view prev_state{};
+
+    if (fields.find("prev_pid=") != std::string_view::npos) {
+      prev_pid = ParseField(fields, "prev_pid=");
+      next_pid = ParseField(fields, "next_pid=");
+      prev_state = FieldText(fields, "prev_state=");
+    } else if (const auto arrow{fields.find(" ==> ")}; arrow != std::string_view::npos) {
+      // "comm:pid [prio] state ==> comm:pid [prio]"
+      const auto prev{fields.substr(0, arrow)};
+
+      prev_pid = TaskPid(prev);
+      next_pid = TaskPid(fields.substr(arrow + 5));
+      prev_state = prev.substr(prev.rfind(' ') + 1);
+    }
+
+    if (!prev_pid || !next_pid) {
+      skipped_++;
+      return false;
+    }
+
+    if (*next_pid != 0) {
+      auto& task{tasks_.try_emplace(*next_pid, Task{.arrival = time}).first->second};
+
+      if (task.first_run < 0) {
+        task.first_run = time;
+      }
+
+      task.on_cpu_since = time;
+    }
+
+    if (*prev_pid == 0) {
+      return false;
+    }
+
+    const auto task_it{tasks_.find(*prev_pid)};
+    if (task_it == tasks_.end() || task_it->second.on_cpu_since < 0) {
+      return false;
+    }
+
+    auto& task{task_it->second};
+    task.cpu += time - task.on_cpu_since;
+    task.on_cpu_since = -1;
+
+    // Still runnable: preempted, the burst goes on.
+    if (!prev_state.empty() && prev_state.front() == 'R') {
+      return false;
+    }
+
+    // Every other time is below the switch-out time.
+    if (time > std::numeric_limits<Time>::max()) {
+      overflowed_ = true;
+      return false;
+    }
+
+    process = {.at = static_cast<Time>(task.arrival),
+               .bt = static_cast<Time>(task.cpu),
+               .st = static_cast<Time>(task.first_run),
+               .ct = static_cast<Time>(time),
+               .rbt = static_cast<Time>(task.cpu),
+               .id = emitted_++,
+               .finished = true,
+               .rqt = static_cast<Time>(task.cpu),
+               .cpus = 1};
+
+    process.tt = process.ct - process.at;
+    process.rt = process.st - process.at;
+    process.wt = process.tt - process.bt;
+
+    tasks_.erase(task_it);
+    return true;
+  }
+
+  // "5891.123456:" just before the event name, in microseconds.
+  static std::optional<std::int64_t> ParseTimestamp(std::string_view line) {
+    const auto event{line.find(": sched")};
+    if (event == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    auto begin{line.rfind(' ', event)};
+    begin = begin == std::string_view::npos ? 0 : begin + 1;
+
+    std::int64_t seconds{};
+    std::int64_t microseconds{};
+    int fraction_digits{-1};
+
+    for (const char character : line.substr(begin, event - begin)) {
+      if (character == '.') {
+        fraction_digits = 0;
+      } else if (character < '0' || character > '9') {
+        return std::nullopt;
+      } else if (fraction_digits < 0) {
+        seconds = seconds * 10 + (character - '0');
+      } else if (fraction_digits < 6) {
+        microseconds = microseconds * 10 + (character - '0');
+        fraction_digits++;
+      }
+    }
+
+    for (; fraction_digits < 6; fraction_digits++) {
+      microseconds *= 10;
+    }
+
+    return seconds * 1'000'000 + microseconds;
+  }
+
+  // Value of " key=value" (or of "key=value" at the start of the event fields).
+  static std::string_view FieldText(std::string_view line, std::string_view key) {
+    std::size_t position{};
+
+    while ((position = line.find(key, position)) != std::string_view::npos) {
+      if (position == 0 || line[position - 1] == ' ') {
+        const auto begin{position + key.size()};
+        const auto end{line.find(' ', begin)};
+
+        return line.substr(begin, end == std::string_view::npos ? end : end - begin);
+      }
+
+      position += key.size();
+    }
+
+    return {};
+  }
+
+  static std::optional<std::int64_t> ParseField(std::string_view line, std::string_view key) {
+    return ParseNumber(FieldText(line, key));
+  }
+
+  // CPU of the last "[002]" in the event header.
+  static std::optional<std::int64_t> ParseCpu(std::string_view header) {
+    auto close{header.rfind(']')};
+
+    while (close != std::string_view::npos && close > 0) {
+      const auto open{header.rfind('[', close - 1)};
+      if (open == std::string_view::npos) {
+        break;
+      }
+
+      if (const auto cpu{ParseNumber(header.substr(open + 1, close - open - 1))}) {
+        return cpu;
+      }
+
+      close = open > 0 ? header.rfind(']', open - 1) : std::string_view::npos;
+    }
+
+    return std::nullopt;
+  }
+
+  // CPU a wakeup puts the task on: "target_cpu=002", or "CPU:002" from the
+  // sched plugins.
+  static std::optional<std::int64_t> TargetCpu(std::string_view fields) {
+    if (const auto cpu{ParseField(fields, "target_cpu=")}) {
+      return cpu;
+    }
+
+    const auto label{fields.find("CPU:")};
+    if (label == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    const auto begin{label + 4};
+    const auto end{fields.find_first_not_of("0123456789", begin)};
+
+    return ParseNumber(fields.substr(begin, end == std::string_view::npos ? end : end - begin));
+  }
+
+  // Pid of a task written "comm:pid [prio]" by the sched plugins. The comm may
+  // itself hold colons ("kworker/u8:2:123"), so the pid follows the last one.
+  static std::optional<std::int64_t> TaskPid(std::string_view task) {
+    const auto priority{task.find(" [")};
+    if (priority == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    const auto colon{task.rfind(':', priority)};
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+
+    return ParseNumber(task.substr(colon + 1, priority - colon - 1));
+  }
+
+  static std::optional<std::int64_t> ParseNumber(std::string_view text) {
+    if (text.empty() || text.size() > 18) {
+      return std::nullopt;
+    }
+
+    std::int64_t value{};
+    for (const char character : text) {
+      if (character < '0' || character > '9') {
+        return std::nullopt;
+      }
+
+      value = value * 10 + (character - '0');
+    }
+
+    return value;
+  }
+
+  std::ifstream file_stream_;
+  std::string line_{};
+
+  std::optional<std::int64_t> cpu_;
+  std::unordered_map<std::int64_t, Task> tasks_{};
+  std::optional<std::int64_t> origin_{};
+  std::int64_t latest_{};
+
+  std::size_t emitted_{};
+  std::size_t skipped_{};
+  std::size_t out_of_order_{};
+  bool overflowed_{};
+};
+
+using SchedTraceReader = BasicSchedTraceReader<>;
+
+// What reading a sched trace left out.
+struct SchedTraceStatus {
+  std::size_t skipped;       // Lines that looked like sched events but could not be parsed
+  std::size_t out_of_order;  // Events older than one read before them
+  bool overflowed;           // Stopped early at a time past the range of Time
+};
+
+// Every complete burst of a sched trace (of one CPU, if given), in the order
+// the bursts ended. What was left out is stored in `status`, if not null.
+template <typename Time = int>
+std::vector<BasicProcess<Time>> ReadSchedTrace(const std::filesystem::path& filepath,
+                                               std::optional<std::int64_t> cpu = std::nullopt,
+                                               SchedTraceStatus* status = nullptr) {
+  BasicSchedTraceReader<Time> reader{filepath, cpu};
+  if (!reader.is_open()) {
+    return {};
+  }
+
+  std::vector<BasicProcess<Time>> processes{};
+
+  BasicProcess<Time> process{};
+  while (reader.Next(process)) {
+    processes.push_back(process);
+  }
+
+  if (status) {
+    *status = {.skipped = reader.skipped(),
+               .out_of_order = reader.out_of_order(),
+               .overflowed = reader.overflowed()};
+  }
+
+  return processes;
+}
+}  // namespace ps
@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+
+#include "admission.h"
+#include "arena.h"
+#include "counters.h"
+#include "histogram.h"
+#include "ready_queue.h"
+#include "trace.h"
+
+namespace ps {
+// Version of the scheduling semantics. Bump it with any change that alters a
+// schedule or a metric, so results cached by earlier builds are recomputed
+// (see result_cache.h).
+inline constexpr std::uint32_t kSchedulerVersion = 1;
+
+template <typename Time>
+struct BasicProcess {
+  Time at;   // Arrival time
+  Time bt;   // Burst time
+  Time st;   // Start time
+  Time ct;   // Completion time (start time + burst time)
+  Time tt;   // Turnaround time (completion time - arrival time)
+  Time rt;   // Response time (start time - arrival time)
+  Time wt;   // Wait time (turnaround time - burst time)
+  Time rbt;  // Remaining burst time
+  std::size_t id;  // Position in the input (used in traces and as last tie-breaker)
+  bool finished;
+  bool dropped;        // Shed by a bounded ready queue (see QueueLimit)
+  Time rqt;            // Requested (user estimated) burst time, if the input has it
+  std::uint32_t cpus;  // Processors used, if the input has them (0 otherwise)
+};
+
+using Process = BasicProcess<int>;
+
+struct ProcessAverageMetrics {
+  float tt;
+  float rt;
+  float wt;
+};
+
+struct ProcessHistograms {
+  LatencyHistogram tt;
+  LatencyHistogram rt;
+  LatencyHistogram wt;
+
+  template <typename P>
+  void Record(const P& process) {
+    tt.Record(process.tt);
+    rt.Record(process.rt);
+    wt.Record(process.wt);
+  }
+
+  void Reset() {
+    tt.Reset();
+    rt.Reset();
+    wt.Reset();
+  }
+};
+
+// Metrics sinks receive every process as it completes (see also
+// ColumnarMetricsSink, which summarizes a run once it completes).
+
+// Averages only.
+struct AverageMetricsSink {
+  template <typename P>
+  constexpr void Record(const P& process) {
+    tt += static_cast<double>(process.tt);
+    rt += static_cast<double>(process.rt);
+    wt += static_cast<double>(process.wt);
+    count++;
+  }
+
+  constexpr void Reset() { *this = {}; }
+
+  constexpr ProcessAverageMetrics Average() const {
+    if (count == 0) {
+      return {};
+    }
+
+    const auto divisor{static_cast<double>(count)};
+    return {static_cast<float>(tt / divisor), static_cast<float>(rt / divisor),
+            static_cast<float>(wt / divisor)};
+  }
+
+  double tt;
+  double rt;
+  double wt;
+  std::size_t count;
+};
+
+// Averages plus the distributions needed for percentiles.
+struct HistogramMetricsSink : AverageMetricsSink {
+  template <typename P>
+  void Record(const P& process) {
+    AverageMetricsSink::Record(process);
+    histograms.Record(process);
+  }
+
+  void Reset() {
+    AverageMetricsSink::Reset();
+    histograms.Reset();
+  }
+
+  ProcessHistograms histograms{};
+};
+
+// Selection policies decide which ready process runs first (Before, used by
+// ordered queues) and for how long it runs once dispatched (Slice).
+
+// First come first serve: arrival order, runs to completion.
+struct FCFSPolicy {
+  template <typename P>
+  static constexpr bool Before(const P& lhs, const P& rhs) {
+    return lhs.at < rhs.at || (lhs.at == rhs.at && lhs.id < rhs.id);
+  }
+
+  template <typename Time>
+  constexpr Time Slice(Time remaining) const {
+    return remaining;
+  }
+};
+
+// Shortest job first (non-preemptive): shortest burst, then earliest arrival.
+struct SJFPolicy {
+  template <typename P>
+  static constexpr bool Before(const P& lhs, const P& rhs) {
+    if (lhs.bt != rhs.bt) {
+      return lhs.bt < rhs.bt;
+    }
+
+    return FCFSPolicy::Before(lhs, rhs);
+  }
+
+  template <typename Time>
+  constexpr Time Slice(Time remaining) const {
+    return remaining;
+  }
+};
+
+// Round robin: arrival order, preempted after `quantum`.
+struct RRPolicy {
+  constexpr RRPolicy(int quantum = 1) : quantum{std::max(quantum, 1)} {}
+
+  template <typename P>
+  static constexpr bool Before(const P& lhs, const P& rhs) {
+    return FCFSPolicy::Before(lhs, rhs);
+  }
+
+  template <typename Time>
+  constexpr Time Slice(Time remaining) const {
+    return std::min(remaining, static_cast<Time>(quantum));
+  }
+
+  int quantum;
+};
+
+template <typename Scheduler>
+class Checkpointer;
+
+template <typename Policy, typename P, typename Counters = NullCounters,
+          typename Table = std::vector<P>>
+struct ProcessOrder {
+  const Table* processes{};
+  [[no_unique_address]] std::conditional_t<Counters::kEnabled, Counters*, NullCounters> counters{};
+
+  constexpr bool operator()(std::size_t lhs, std::size_t rhs) const {
+    if constexpr (Counters::kEnabled) {
+      counters->comparisons++;
+    }
+
+    return Policy::Before((*processes)[lhs], (*processes)[rhs]);
+  }
+};
+
+// Single CPU scheduler assembled at compile time from a selection policy, a
+// ready queue, the integer type used for times and a metrics sink, so the
+// whole dispatch loop is inlined for each combination.
+//
+// Arrivals are admitted in arrival order whenever the clock reaches them, and
+// those that arrive while a process runs are queued before it is requeued.
+//
+// With Counters = SchedulerCounters (the default under PS_ENABLE_COUNTERS),
+// each Start also counts its dispatches, queue operations and comparisons.
+//
+// The process table and the ready queue are allocated with Allocator, so with
+// an ArenaAllocator (ArenaScheduler) a run can take all its memory from one
+// arena and give it back at once (see arena.h), and with a
+// std::pmr::polymorphic_allocator (PmrScheduler) from any memory resource.
+template <typename Policy, template <typename...> class Queue, typename Time = int,
+          typename Sink = HistogramMetricsSink, typename Counters = DefaultCounters,
+          typename Allocator = std::allocator<std::byte>>
+class BasicScheduler {
+ public:
+  using ProcessType = BasicProcess<Time>;
+  using ProcessTable = std::vector<
+      ProcessType, typename std::allocator_traits<Allocator>::template rebind_alloc<ProcessType>>;
+
+  // `processes` is any range of processes: a vector, or a MappedWorkload
+  // decoded straight from a file.
+  template <std::ranges::input_range Processes>
+  constexpr explicit BasicScheduler(const Processes& processes, Policy policy = {},
+                                    const Allocator& allocator = {})
+      : processes_(allocator), policy_{policy}, queue_{OrderType{}, allocator} {
+    if constexpr (std::ranges::sized_range<const Processes>) {
+      processes_.reserve(std::ranges::size(processes));
+    }
+
+    for (const auto& process : processes) {
+      processes_.push_back({.at = static_cast<Time>(process.at),
+                            .bt = static_cast<Time>(process.bt),
+                            .id = process.id,
+                            .rqt = static_cast<Time>(process.rqt),
+                            .cpus = process.cpus});
+    }
+  }
+
+  constexpr ProcessAverageMetrics Start() {
+    Begin();
+    Step(std::numeric_limits<std::size_t>::max());
+
+    return sink_.Average();
+  }
+
+  // Start in steps, so a long run can be checkpointed between dispatches
+  // (see checkpoint.h): Begin, then Step until it returns false.
+
+  // Sorts the processes by arrival and clears the results of any earlier run.
+  constexpr void Begin() {
+    auto comparer = [](const ProcessType& lhs, const ProcessType& rhs) {
+      return FCFSPolicy::Before(lhs, rhs);
+    };
+
+    std::sort(processes_.begin(), processes_.end(), comparer);
+
+    for (auto& process : processes_) {
+      process.rbt = process.bt;
+      process.finished = false;
+      process.dropped = false;
+    }
+
+    sink_.Reset();
+    counters_.Reset();
+
+    BindQueue();
+    queue_.Reserve(processes_.size());
+
+    clock_ = {};
+    next_arrival_ = 0;
+    finished_count_ = 0;
+  }
+
+  // Runs up to `dispatches` dispatches, idling whenever nothing is ready.
+  // Returns false once every process has completed.
+  constexpr bool Step(std::size_t dispatches = 1) {
+    // Locals, so the loop state stays in registers.
+    Time clock{clock_};
+    std::size_t next_arrival{next_arrival_};
+    std::size_t finished_count{finished_count_};
+
+    for (; dispatches > 0 && finished_count < processes_.size(); dispatches--) {
+      Admit(clock, next_arrival, finished_count);
+
+      if (queue_.empty()) {
+        // The last arrivals were dropped.
+        if (finished_count == processes_.size()) {
+          break;
+        }
+
+        Count(&SchedulerCounters::idle_ticks, processes_[next_arrival].at - clock);
+
+        clock = processes_[next_arrival].at;
+        Admit(clock, next_arrival, finished_count);
+      }
+
+      const auto index{queue_.Pop()};
+      auto& process{processes_[index]};
+
+      Count(&SchedulerCounters::pops);
+      Count(&SchedulerCounters::events);
+
+      if (process.rbt == process.bt) {
+        process.st = clock;
+      }
+
+      const Time slice_start{clock};
+      const Time slice{policy_.Slice(process.rbt)};
+
+      clock += slice;
+      process.rbt -= slice;
+
+      if (process.rbt == 0) {
+        process.ct = clock;
+        process.finished = true;
+
+        if constexpr (!kDeferredSink) {
+          process.tt = process.ct - process.at;
+          process.rt = process.st - process.at;
+          process.wt = process.tt - process.bt;
+
+          sink_.Record(process);
+        }
+
+        finished_count++;
+      }
+
+      if (trace_) {
+        trace_->Slice(process.id, 0, slice_start, slice,
+                      process.finished ? TraceWriter::SliceEnd::kCompleted
+                                       : TraceWriter::SliceEnd::kPreempted);
+      }
+
+      if (!process.finished) {
+        Admit(clock, next_arrival, finished_count, 1);
+
+        queue_.Push(index);
+        Count(&SchedulerCounters::pushes);
+      }
+    }
+
+    if constexpr (kDeferredSink) {
+      if (finished_count == processes_.size() && finished_count_ < processes_.size()) {
+        FinishSink();
+      }
+    }
+
+    clock_ = clock;
+    next_arrival_ = next_arrival;
+    finished_count_ = finished_count;
+
+    return finished_count < processes_.size();
+  }
+
+  // Processes in arrival order, with the results of the last Start.
+  constexpr const ProcessTable& processes() const { return processes_; }
+
+  constexpr const Sink& metrics() const { return sink_; }
+
+  // Distributions of the metrics recorded by the last Start.
+  const ProcessHistograms& histograms() const
+    requires requires(const Sink& sink) { sink.histograms; }
+  {
+    return sink_.histograms;
+  }
+
+  constexpr const Policy& policy() const { return policy_; }
+
+  // Bytes a scheduler and one Start allocate for `process_count` processes:
+  // the process table and the ready queue, to size an arena (see arena.h).
+  static constexpr std::size_t ArenaBytes(std::size_t process_count) {
+    constexpr std::size_t kAlignmentSlack{alignof(std::max_align_t)};
+
+    return process_count * sizeof(ProcessType) +
+           std::max<std::size_t>(process_count, 1) * sizeof(std::size_t) + 2 * kAlignmentSlack;
+  }
+
+  // Hot-path counts of the last Start (empty with NullCounters).
+  constexpr const Counters& counters() const { return counters_; }
+
+  // Emits every dispatch of the next Start to `trace`, if not null.
+  void set_trace(TraceWriter* trace) { trace_ = trace; }
+
+  // Bounds the ready queue of the next Start (see QueueLimit). Processes it
+  // drops are counted as done but have no results, and no metrics.
+  void set_queue_limit(QueueLimit limit) { limit_ = limit; }
+
+  constexpr const QueueLimit& queue_limit() const { return limit_; }
+
+  // Drops and goodput of the last Start.
+  OverloadMetrics overload() const {
+    std::size_t dropped{};
+    double work{};
+
+    for (const auto& process : processes_) {
+      if (process.dropped) {
+        dropped++;
+      } else if (process.finished) {
+        work += static_cast<double>(process.bt);
+      }
+    }
+
+    const auto count{static_cast<double>(std::max<std::size_t>(processes_.size(), 1))};
+    const auto elapsed{static_cast<double>(clock_)};
+
+    return {.dropped = dropped,
+            .drop_rate = static_cast<float>(static_cast<double>(dropped) / count),
+            .goodput = static_cast<float>(elapsed > 0 ? work / elapsed : 0.0)};
+  }
+
+ private:
+  using OrderType = ProcessOrder<Policy, ProcessType, Counters, ProcessTable>;
+  using QueueType =
+      Queue<OrderType, typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>>;
+
+  template <typename>
+  friend class Checkpointer;
+
+  // Sinks with kDeferred (ColumnarMetricsSink) summarize the whole table once
+  // the run completes instead of recording each completion.
+  static constexpr bool kDeferredSink = requires { requires Sink::kDeferred; };
+
+  // Points the queue at this scheduler's table (and counters), keeping its
+  // storage and allocator.
+  constexpr void BindQueue() {
+    if constexpr (Counters::kEnabled) {
+      queue_.set_order(OrderType{&processes_, &counters_});
+    } else {
+      queue_.set_order(OrderType{&processes_});
+    }
+  }
+
+  // Queues every process that has arrived by `clock`, as far as the queue
+  // limit lets it with `reserved` slots kept. Dropped processes count as
+  // finished; delayed ones stay ahead of `next_arrival`.
+  constexpr void Admit(Time clock, std::size_t& next_arrival, std::size_t& finished_count,
+                       std::size_t reserved = 0) {
+    Count(&SchedulerCounters::rescans);
+
+    while (next_arrival < processes_.size() && processes_[next_arrival].at <= clock) {
+      if (limit_.capacity > 0 && queue_.size() + reserved >= limit_.capacity) {
+        if (limit_.admission == Admission::kDelay) {
+          break;
+        }
+
+        // With the only slot kept for a preempted process, the arrival itself
+        // is the one dropped.
+        auto dropped{next_arrival};
+        if (limit_.admission == Admission::kDropOldest && !queue_.empty()) {
+          dropped = queue_.PopLowest();
+        }
+
+        processes_[dropped].dropped = true;
+        finished_count++;
+
+        if (dropped == next_arrival) {
+          next_arrival++;
+          continue;
+        }
+      }
+
+      queue_.Push(next_arrival++);
+      Count(&SchedulerCounters::pushes);
+    }
+  }
+
+  // Deferred sinks summarize the table in place, leaving out dropped
+  // processes, which have no results, and fill in the tt, rt and wt of the
+  // others.
+  void FinishSink() { sink_.Finish(processes_); }
+
+  constexpr void Count(std::uint64_t SchedulerCounters::*counter, std::uint64_t amount = 1) {
+    if constexpr (Counters::kEnabled) {
+      counters_.*counter += amount;
+    }
+  }
+
+  ProcessTable processes_{};
+  Policy policy_;
+  QueueType queue_{};
+  Sink sink_{};
+  [[no_unique_address]] Counters counters_{};
+  TraceWriter* trace_{};
+  QueueLimit limit_{};
+
+  Time clock_{};
+  std::size_t next_arrival_{};
+  std::size_t finished_count_{};
+};
+
+using FCFSScheduler = BasicScheduler<FCFSPolicy, FifoQueue>;
+using SJFScheduler = BasicScheduler<SJFPolicy, HeapQueue>;
+using RRScheduler = BasicScheduler<RRPolicy, FifoQueue>;
+
+// Takes an ArenaAllocator from RunArena::Begin as last constructor argument.
+template <typename Policy, template <typename...> class Queue, typename Time = int,
+          typename Sink = HistogramMetricsSink, typename Counters = DefaultCounters>
+using ArenaScheduler =
+    BasicScheduler<Policy, Queue, Time, Sink, Counters, ArenaAllocator<std::byte>>;
+
+// Takes a std::pmr::memory_resource* as last constructor argument. Slower than
+// ArenaScheduler over a monotonic resource, for the virtual allocation calls.
+template <typename Policy, template <typename...> class Queue, typename Time = int,
+          typename Sink = HistogramMetricsSink, typename Counters = DefaultCounters>
+using PmrScheduler =
+    BasicScheduler<Policy, Queue, Time, Sink, Counters, std::pmr::polymorphic_allocator<std::byte>>;
+
+// Runs a fixed workload through one algorithm, also at compile time:
+//   static_assert(Simulate<FCFSPolicy, FifoQueue>(workload).tt == 30.5F);
+template <typename Policy, template <typename> class Queue, std::size_t N>
+constexpr ProcessAverageMetrics Simulate(const std::array<Process, N>& workload,
+                                         Policy policy = {}) {
+  const std::vector<Process> processes(workload.begin(), workload.end());
+  return BasicScheduler<Policy, Queue, int, AverageMetricsSink>{processes, policy}.Start();
+}
+
+// RR metrics of a fixed workload for every quantum in [1, MaxQuantum], indexed
+// by quantum - 1. Meant to be precomputed into a constexpr table.
+template <int MaxQuantum, std::size_t N>
+constexpr std::array<ProcessAverageMetrics, MaxQuantum> RRQuantumTable(
+    const std::array<Process, N>& workload) {
+  std::array<ProcessAverageMetrics, MaxQuantum> table{};
+
+  for (int quantum = 1; quantum <= MaxQuantum; quantum++) {
+    table[quantum - 1] = Simulate<RRPolicy, FifoQueue>(workload, RRPolicy{quantum});
+  }
+
+  return table;
+}
+
+// Whether every time reached while scheduling `processes` fits in Time.
+template <typename Time, typename Processes>
+bool FitsTime(const Processes& processes) {
+  std::int64_t last_arrival{};
+  std::int64_t total_burst{};
+
+  for (const auto& process : processes) {
+    last_arrival = std::max<std::int64_t>(last_arrival, process.at);
+    total_burst += process.bt;
+  }
+
+  return last_arrival + total_burst <= std::numeric_limits<Time>::max();
+}
+}  // namespace ps
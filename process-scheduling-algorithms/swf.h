@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "scheduler.h"
+
+namespace ps {
+// Streaming reader of Standard Workload Format logs (Parallel Workloads
+// Archive). Each job line maps onto a process:
+//   at   <- submit time (field 2)
+//   bt   <- run time (field 4), or the requested time if the run time is missing
+//   cpus <- allocated processors (field 5), or the requested ones (field 8)
+//   rqt  <- requested time (field 9), or the run time if it is missing
+// Header comments (";") are skipped, as are jobs with neither a run time nor a
+// requested time and jobs whose times do not fit in a Process (past INT_MAX).
+// The file is read in large blocks and parsed in place, with no per-line
+// allocation, so large logs are bounded by I/O rather than parsing.
+class SwfReader {
+ public:
+  static constexpr std::size_t kBlockSize = 4 << 20;
+
+  explicit SwfReader(const std::filesystem::path& filepath)
+      : file_stream_{filepath, std::ios::in | std::ios::binary}, buffer_(kBlockSize) {}
+
+  bool is_open() const { return file_stream_.is_open(); }
+
+  // Reads the next job into `process`. Returns false at the end of the log.
+  bool Next(Process& process) {
+    while (true) {
+      const char* line_end{FindLineEnd()};
+      if (!line_end) {
+        return false;
+      }
+
+      const char* line{buffer_.data() + position_};
+      position_ = static_cast<std::size_t>(line_end - buffer_.data()) + 1;
+
+      if (ParseLine(line, line_end, process)) {
+        return true;
+      }
+    }
+  }
+
+  // Job lines that could not be used.
+  std::size_t skipped() const { return skipped_; }
+
+ private:
+  static constexpr std::size_t kFieldCount = 9;
+
+  // Next '\n' in the buffer, refilling it as needed. At the end of the file a
+  // last line without a newline gets one appended.
+  const char* FindLineEnd() {
+    while (true) {
+      const char* begin{buffer_.data() + position_};
+      const char* end{buffer_.data() + size_};
+
+      if (const auto* newline{static_cast<const char*>(std::memchr(begin, '\n', end - begin))}) {
+        return newline;
+      }
+
+      if (eof_) {
+        if (begin == end) {
+          return nullptr;
+        }
+
+        buffer_[size_++] = '\n';
+        return buffer_.data() + size_ - 1;
+      }
+
+      Refill();
+    }
+  }
+
+  // Moves the unread tail to the front and reads the next block after it.
+  void Refill() {
+    const auto tail{size_ - position_};
+    std::memmove(buffer_.data(), buffer_.data() + position_, tail);
+
+    // A line longer than a block: grow the buffer instead.
+    if (tail + 1 >= buffer_.size()) {
+      buffer_.resize(buffer_.size() * 2);
+    }
+
+    file_stream_.read(buffer_.data() + tail, static_cast<std::streamsize>(buffer_.size() - tail - 1));
+
+    position_ = 0;
+    size_ = tail + static_cast<std::size_t>(file_stream_.gcount());
+    eof_ = !file_stream_;
+  }
+
+  bool ParseLine(const char* cursor, const char* end, Process& process) {
+    while (cursor < end && IsBlank(*cursor)) {
+      cursor++;
+    }
+
+    if (cursor == end || *cursor == ';') {
+      return false;
+    }
+
+    std::array<std::int64_t, kFieldCount> fields{};
+    for (auto& field : fields) {
+      if (!ParseField(cursor, end, field)) {
+        skipped_++;
+        return false;
+      }
+    }
+
+    const auto submit_time{fields[1]};
+    const auto run_time{fields[3]};
+    const auto allocated_processors{fields[4]};
+    const auto requested_processors{fields[7]};
+    const auto requested_time{fields[8]};
+
+    const auto burst{run_time >= 0 ? run_time : requested_time};
+    const auto requested{requested_time >= 0 ? requested_time : burst};
+    const auto processors{allocated_processors > 0 ? allocated_processors : requested_processors};
+
+    constexpr std::int64_t kMaxTime{std::numeric_limits<int>::max()};
+    constexpr std::int64_t kMaxProcessors{std::numeric_limits<std::uint32_t>::max()};
+
+    if (submit_time < 0 || burst < 0 || submit_time > kMaxTime || burst > kMaxTime ||
+        requested > kMaxTime || processors > kMaxProcessors) {
+      skipped_++;
+      return false;
+    }
+
+    process = {.at = static_cast<int>(submit_time),
+               .bt = static_cast<int>(burst),
+               .rbt = static_cast<int>(burst),
+               .id = parsed_++,
+               .rqt = static_cast<int>(requested),
+               .cpus = static_cast<std::uint32_t>(processors > 0 ? processors : 0)};
+
+    return true;
+  }
+
+  // Integer part of the next whitespace separated number ("-1", "12", "3.5").
+  // Fails on numbers too long for 64 bits.
+  static bool ParseField(const char*& cursor, const char* end, std::int64_t& value) {
+    while (cursor < end && IsBlank(*cursor)) {
+      cursor++;
+    }
+
+    const bool negative{cursor < end && *cursor == '-'};
+    if (negative) {
+      cursor++;
+    }
+
+    const char* digits{cursor};
+
+    value = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+      if (value > (std::numeric_limits<std::int64_t>::max() - 9) / 10) {
+        return false;
+      }
+
+      value = value * 10 + (*cursor++ - '0');
+    }
+
+    if (cursor == digits) {
+      return false;
+    }
+
+    while (cursor < end && !IsBlank(*cursor)) {
+      cursor++;
+    }
+
+    if (negative) {
+      value = -value;
+    }
+
+    return true;
+  }
+
+  static bool IsBlank(char character) {
+    return character == ' ' || character == '\t' || character == '\r';
+  }
+
+  std::ifstream file_stream_;
+  std::vector<char> buffer_;
+  std::size_t position_{};
+  std::size_t size_{};
+  bool eof_{};
+
+  std::size_t parsed_{};
+  std::size_t skipped_{};
+};
+
+// Whole SWF log as processes, in file order. The number of job lines that
+// could not be used is stored in `skipped`, if not null.
+inline std::vector<Process> ReadSwf(const std::filesystem::path& filepath,
+                                    std::size_t* skipped = nullptr) {
+  SwfReader reader{filepath};
+  if (!reader.is_open()) {
+    return {};
+  }
+
+  std::vector<Process> processes{};
+
+  Process process{};
+  while (reader.Next(process)) {
+    processes.push_back(process);
+  }
+
+  if (skipped) {
+    *skipped = reader.skipped();
+  }
+
+  return processes;
+}
+}  // namespace ps
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ps {
+// Timer queues hold (due time, process index) events for event loops such as
+// CoroutineScheduler. Expire(now, on_expired) calls on_expired(index) for every
+// event due by `now`, in order of due time and then index, so every timer
+// queue delivers the same events in the same order.
+
+// Binary min-heap: O(log n) Schedule and expiry.
+template <typename Time>
+class TimerHeap {
+ public:
+  void Reserve(std::size_t capacity) { events_.reserve(capacity); }
+
+  void Schedule(Time due, std::size_t index) {
+    events_.emplace_back(due, index);
+    std::push_heap(events_.begin(), events_.end(), std::greater<>{});
+  }
+
+  bool empty() const { return events_.empty(); }
+  std::size_t size() const { return events_.size(); }
+
+  // Due time of the earliest event; the queue must not be empty.
+  Time NextDue() const { return events_.front().first; }
+
+  template <typename OnExpired>
+  void Expire(Time now, OnExpired&& on_expired) {
+    while (!events_.empty() && events_.front().first <= now) {
+      std::pop_heap(events_.begin(), events_.end(), std::greater<>{});
+
+      const auto index{events_.back().second};
+      events_.pop_back();
+
+      on_expired(index);
+    }
+  }
+
+ private:
+  std::vector<std::pair<Time, std::size_t>> events_{};
+};
+
+// Hierarchical timing wheel: levels of 64 slots, level l covering 64^l time
+// units per slot. An event goes to the level of the highest 6-bit digit in
+// which its due time differs from the wheel's current time, so Schedule is
+// O(1) and events due within 64 units land straight in the slot of their exact
+// time. When the wheel advances, the slots of the current time's digits are
+// cascaded into the levels below; each event moves down at most once per
+// level. Occupancy bitmaps find the next non-empty slot in one bit scan.
+//
+// Times must not go back: events are never due before the last Expire.
+template <typename Time>
+class TimingWheel {
+ public:
+  void Reserve(std::size_t capacity) { expired_.reserve(capacity); }
+
+  void Schedule(Time due, std::size_t index) {
+    due = std::max(due, now_);
+    Place({due, index});
+
+    size_++;
+
+    if (next_due_valid_) {
+      next_due_ = std::min(next_due_, due);
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+
+  // Due time of the earliest event; the wheel must not be empty.
+  Time NextDue() const {
+    if (!next_due_valid_) {
+      next_due_ = FindNextDue();
+      next_due_valid_ = true;
+    }
+
+    return next_due_;
+  }
+
+  template <typename OnExpired>
+  void Expire(Time now, OnExpired&& on_expired) {
+    while (!empty() && NextDue() <= now) {
+      Advance(NextDue());
+
+      // Everything left in the current level 0 slot is due now.
+      auto& slot{slots_[0][Digit(now_, 0)]};
+
+      expired_.swap(slot);
+      occupied_[0] &= ~(std::uint64_t{1} << Digit(now_, 0));
+      size_ -= expired_.size();
+      next_due_valid_ = false;
+
+      std::sort(expired_.begin(), expired_.end(),
+                [](const Event& lhs, const Event& rhs) { return lhs.index < rhs.index; });
+
+      for (const auto& event : expired_) {
+        on_expired(event.index);
+      }
+
+      expired_.clear();
+    }
+
+    if (now > now_) {
+      Advance(now);
+    }
+  }
+
+ private:
+  struct Event {
+    Time due;
+    std::size_t index;
+  };
+
+  using Bits = std::make_unsigned_t<Time>;
+
+  static constexpr int kSlotBits = 6;
+  static constexpr std::size_t kSlotCount = std::size_t{1} << kSlotBits;
+  static constexpr int kLevelCount = (std::numeric_limits<Bits>::digits + kSlotBits - 1) / kSlotBits;
+
+  static std::size_t Digit(Time time, int level) {
+    return static_cast<std::size_t>((static_cast<Bits>(time) >> (level * kSlotBits)) &
+                                    (kSlotCount - 1));
+  }
+
+  int LevelOf(Time due) const {
+    const auto difference{static_cast<Bits>(due) ^ static_cast<Bits>(now_)};
+    return difference == 0 ? 0 : (std::bit_width(difference) - 1) / kSlotBits;
+  }
+
+  void Place(const Event& event) {
+    const auto level{LevelOf(event.due)};
+    const auto digit{Digit(event.due, level)};
+
+    slots_[level][digit].push_back(event);
+    occupied_[level] |= std::uint64_t{1} << digit;
+  }
+
+  // Moves the current time to `time`, no later than any event, and cascades
+  // the events that now differ from it in a lower digit. Only the slot of a
+  // digit that just changed can hold such events, so levels above the highest
+  // changed digit are left alone: most steps only touch level 0.
+  void Advance(Time time) {
+    const auto changed{static_cast<Bits>(time) ^ static_cast<Bits>(now_)};
+    now_ = time;
+
+    if (changed < kSlotCount) {
+      return;
+    }
+
+    for (int level = (std::bit_width(changed) - 1) / kSlotBits; level > 0; level--) {
+      const auto digit{Digit(now_, level)};
+
+      if ((occupied_[level] & (std::uint64_t{1} << digit)) == 0) {
+        continue;
+      }
+
+      cascading_.swap(slots_[level][digit]);
+      occupied_[level] &= ~(std::uint64_t{1} << digit);
+
+      for (const auto& event : cascading_) {
+        Place(event);
+      }
+
+      cascading_.clear();
+    }
+  }
+
+  // Every event of a level shares the digits above it with the current time
+  // and has a later digit at that level, so the earliest event is in the
+  // first occupied slot of the lowest occupied level.
+  Time FindNextDue() const {
+    for (int level = 0; level < kLevelCount; level++) {
+      if (occupied_[level] == 0) {
+        continue;
+      }
+
+      const auto digit{static_cast<std::size_t>(std::countr_zero(occupied_[level]))};
+      const auto& slot{slots_[level][digit]};
+
+      if (level == 0) {
+        return slot.front().due;
+      }
+
+      return std::min_element(slot.begin(), slot.end(), [](const Event& lhs, const Event& rhs) {
+               return lhs.due < rhs.due;
+             })->due;
+    }
+
+    return std::numeric_limits<Time>::max();
+  }
+
+  std::array<std::array<std::vector<Event>, kSlotCount>, kLevelCount> slots_{};
+  std::array<std::uint64_t, kLevelCount> occupied_{};
+  std::vector<Event> expired_{};
+  std::vector<Event> cascading_{};
+
+  Time now_{};
+  std::size_t size_{};
+  mutable Time next_due_{};
+  mutable bool next_due_valid_{};
+};
+}  // namespace ps
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace ps {
+// Streams scheduling decisions as Chrome trace-event JSON, loadable in
+// chrome://tracing and ui.perfetto.dev. Every scheduler run becomes a trace
+// process with one track per CPU, and every dispatch becomes a slice that ends
+// with either a preemption or a completion. One simulated time unit is shown as
+// one microsecond. Events are formatted into an in-memory block that is only
+// written out once it is full.
+class TraceWriter {
+ public:
+  enum class SliceEnd { kPreempted, kCompleted };
+
+  static constexpr std::size_t kBlockSize = 1 << 20;
+
+  explicit TraceWriter(const std::filesystem::path& filepath)
+      : file_stream_{filepath, std::ios::out | std::ios::binary | std::ios::trunc} {
+    buffer_.reserve(kBlockSize + kMaxEventSize);
+    Append(R"({"traceEvents":[)");
+  }
+
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+
+  ~TraceWriter() {
+    if (file_stream_.is_open()) {
+      Close();
+    }
+  }
+
+  bool is_open() const { return file_stream_.is_open(); }
+
+  // Ends the trace and closes the file, returning false if any of it could not
+  // be written. Nothing may be traced afterwards.
+  bool Close() {
+    Append("\n]}\n");
+    Flush();
+    file_stream_.close();
+
+    failed_ = failed_ || file_stream_.fail();
+    return !failed_;
+  }
+
+  // Starts the tracks of a new scheduler run, e.g. one per policy.
+  void BeginProcess(std::string_view name, int cpu_count = 1) {
+    pid_++;
+
+    BeginEvent();
+    Append(R"({"name":"process_name","ph":"M","pid":)");
+    AppendInteger(pid_);
+    Append(R"(,"args":{"name":")");
+    Append(name);
+    Append(R"("}})");
+
+    for (int cpu = 0; cpu < cpu_count; cpu++) {
+      BeginEvent();
+      Append(R"({"name":"thread_name","ph":"M","pid":)");
+      AppendInteger(pid_);
+      Append(R"(,"tid":)");
+      AppendInteger(cpu);
+      Append(R"(,"args":{"name":"CPU )");
+      AppendInteger(cpu);
+      Append(R"("}})");
+    }
+  }
+
+  // Process `id` was dispatched on `cpu` at `start` and ran for `duration`.
+  void Slice(std::size_t id, int cpu, std::int64_t start, std::int64_t duration, SliceEnd end) {
+    BeginEvent();
+    Append(R"({"name":"P)");
+    AppendInteger(id);
+    Append(R"(","ph":"X","pid":)");
+    AppendInteger(pid_);
+    Append(R"(,"tid":)");
+    AppendInteger(cpu);
+    Append(R"(,"ts":)");
+    AppendInteger(start);
+    Append(R"(,"dur":)");
+    AppendInteger(duration);
+    Append(end == SliceEnd::kCompleted ? R"(,"args":{"end":"completed"}})"
+                                       : R"(,"args":{"end":"preempted"}})");
+
+    if (buffer_.size() >= kBlockSize) {
+      Flush();
+    }
+  }
+
+ private:
+  // Upper bound of a single formatted event, so a block never reallocates.
+  static constexpr std::size_t kMaxEventSize = 512;
+
+  void BeginEvent() {
+    Append(first_event_ ? "\n" : ",\n");
+    first_event_ = false;
+  }
+
+  void Append(std::string_view text) { buffer_.append(text); }
+
+  template <typename Integer>
+  void AppendInteger(Integer value) {
+    char digits[24];
+    const auto result{std::to_chars(std::begin(digits), std::end(digits), value)};
+
+    buffer_.append(digits, result.ptr);
+  }
+
+  void Flush() {
+    if (!file_stream_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) {
+      failed_ = true;
+    }
+
+    buffer_.clear();
+  }
+
+  std::ofstream file_stream_;
+  std::string buffer_{};
+  bool first_event_{true};
+  bool failed_{};  // A block could not be written, e.g. because the disk is full
+  int pid_{};
+};
+}  // namespace ps
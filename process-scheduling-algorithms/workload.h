@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "scheduler.h"
+
+namespace ps {
+enum class ArrivalPattern {
+  kPoisson,  // Exponential gaps between arrivals
+  kBursty,   // Clusters of close arrivals separated by long idle gaps
+};
+
+enum class BurstDistribution {
+  kExponential,
+  kPareto,   // Heavy tailed: a few very long jobs
+  kBimodal,  // Mostly short jobs mixed with some long ones
+};
+
+struct WorkloadOptions {
+  std::uint64_t seed{42};
+
+  ArrivalPattern arrivals{ArrivalPattern::kPoisson};
+  double mean_gap{12.0};      // Mean time between two arrivals, for both patterns
+  double cluster_size{8.0};   // Mean arrivals per cluster (bursty)
+  double burstiness{10.0};    // How much closer arrivals are inside a cluster (bursty)
+
+  BurstDistribution bursts{BurstDistribution::kExponential};
+  double mean_burst{10.0};    // Exponential and Pareto
+  double pareto_shape{1.5};   // Pareto, must be > 1
+  double short_burst{4.0};    // Bimodal
+  double long_burst{60.0};    // Bimodal
+  double long_fraction{0.1};  // Bimodal
+};
+
+// Arrivals grow with the process count and pass INT_MAX after about 2e8
+// processes at the default mean gap, so generated times are 64-bit. Bursts
+// stay below INT_MAX / 2.
+using GeneratedProcess = BasicProcess<std::int64_t>;
+
+// Seeded synthetic workload, generated on demand in arrival order. Samples are
+// derived directly from the 64-bit engine output (not from the <random>
+// distributions), so a seed gives the same workload with every standard
+// library.
+class WorkloadGenerator {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = GeneratedProcess;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const GeneratedProcess*;
+    using reference = const GeneratedProcess&;
+
+    Iterator() = default;
+    Iterator(WorkloadGenerator* generator, std::size_t remaining)
+        : generator_{generator}, remaining_{remaining} {
+      if (remaining_ > 0) {
+        current_ = generator_->Next();
+      }
+    }
+
+    reference operator*() const { return current_; }
+    pointer operator->() const { return &current_; }
+
+    Iterator& operator++() {
+      if (--remaining_ > 0) {
+        current_ = generator_->Next();
+      }
+
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(const Iterator& other) const { return remaining_ == other.remaining_; }
+
+   private:
+    WorkloadGenerator* generator_{};
+    std::size_t remaining_{};
+    GeneratedProcess current_{};
+  };
+
+  // The next `count` processes, as an input range.
+  struct Range {
+    Iterator first;
+    Iterator last;
+
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+  };
+
+  explicit WorkloadGenerator(const WorkloadOptions& options)
+      : options_{options}, engine_{options.seed} {}
+
+  GeneratedProcess Next() {
+    clock_ += NextGap();
+
+    const auto at{static_cast<std::int64_t>(clock_)};
+    const std::int64_t bt{NextBurst()};
+
+    return {.at = at, .bt = bt, .rbt = bt, .id = generated_++};
+  }
+
+  Range Take(std::size_t count) { return {Iterator{this, count}, Iterator{}}; }
+
+ private:
+  // Uniform in [0, 1).
+  double Uniform() { return static_cast<double>(engine_() >> 11) * 0x1.0p-53; }
+
+  double Exponential(double mean) { return -mean * std::log1p(-Uniform()); }
+
+  double NextGap() {
+    if (generated_ == 0) {
+      return 0.0;
+    }
+
+    if (options_.arrivals == ArrivalPattern::kPoisson) {
+      return Exponential(options_.mean_gap);
+    }
+
+    // Each gap ends the current cluster with probability 1 / cluster_size.
+    // The gap between clusters is sized so the overall mean stays mean_gap.
+    const double cluster_size{std::max(options_.cluster_size, 1.0)};
+    const double inside_fraction{1.0 - 1.0 / cluster_size};
+    const double inside_gap{options_.mean_gap / options_.burstiness};
+    const double outside_gap{(options_.mean_gap - inside_fraction * inside_gap) /
+                             (1.0 - inside_fraction)};
+
+    return Exponential(Uniform() < inside_fraction ? inside_gap : outside_gap);
+  }
+
+  int NextBurst() {
+    double burst{};
+
+    switch (options_.bursts) {
+      case BurstDistribution::kExponential:
+        burst = Exponential(options_.mean_burst);
+        break;
+      case BurstDistribution::kPareto: {
+        const double shape{options_.pareto_shape};
+        const double scale{options_.mean_burst * (shape - 1.0) / shape};
+
+        burst = scale / std::pow(1.0 - Uniform(), 1.0 / shape);
+        break;
+      }
+      case BurstDistribution::kBimodal:
+        burst = Exponential(Uniform() < options_.long_fraction ? options_.long_burst
+                                                               : options_.short_burst);
+        break;
+    }
+
+    constexpr double kMaxBurst{std::numeric_limits<int>::max() / 2};
+    return std::max(1, static_cast<int>(std::lround(std::min(burst, kMaxBurst))));
+  }
+
+  WorkloadOptions options_;
+  std::mt19937_64 engine_;
+  double clock_{};
+  std::size_t generated_{};
+};
+
+// Appends the next `count` processes to a table of 32-bit times. Returns
+// false, with the table cut short, at the first arrival past INT_MAX.
+inline bool TakeInto(WorkloadGenerator& generator, std::size_t count,
+                     std::vector<Process>& table) {
+  table.reserve(table.size() + count);
+
+  for (const auto& process : generator.Take(count)) {
+    if (process.at > std::numeric_limits<int>::max()) {
+      return false;
+    }
+
+    table.push_back({.at = static_cast<int>(process.at),
+                     .bt = static_cast<int>(process.bt),
+                     .rbt = static_cast<int>(process.bt),
+                     .id = process.id});
+  }
+
+  return true;
+}
+}  // namespace ps
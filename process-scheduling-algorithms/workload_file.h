@@ -0,0 +1,399 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "scheduler.h"
+
+namespace ps {
+// Binary columnar workload (".psb"), little-endian:
+//
+//   header   WorkloadFileHeader, 64 bytes
+//   at       count x int32 arrival times, or count x uint16 arrival deltas
+//            (the first one from 0) when kDeltaArrivals is set
+//   bt       count x int32 burst times
+//   rqt      count x int32 requested times       (optional)
+//   cpus     count x uint32 processor counts     (optional)
+//   id       count x uint64 ids                  (optional, file positions if absent)
+//
+// Optional columns are written only when some process needs them, so a plain
+// workload costs at and bt alone. Each column starts on a 64-byte boundary, so
+// a mapped file is decoded without parsing, and pages are only faulted in as
+// the scheduler walks them. A scheduler still copies the rows into its own
+// process table, which it writes its results into.
+struct WorkloadFileHeader {
+  static constexpr std::array<char, 8> kMagic{'P', 'S', 'W', 'O', 'R', 'K', 'L', 'D'};
+  static constexpr std::uint32_t kVersion = 2;  // 1: no optional columns
+
+  // Arrivals are non-decreasing and stored as 16-bit gaps.
+  static constexpr std::uint32_t kDeltaArrivals = 1;
+
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t count;
+  std::uint64_t at_offset;
+  std::uint64_t bt_offset;
+  std::uint64_t rqt_offset;   // 0 when absent, as for every optional column
+  std::uint64_t cpus_offset;
+  std::uint64_t id_offset;
+};
+
+static_assert(sizeof(WorkloadFileHeader) == 64);
+
+namespace detail {
+constexpr std::uint64_t AlignColumn(std::uint64_t offset) {
+  return (offset + 63) & ~std::uint64_t{63};
+}
+
+inline bool WriteColumn(std::ofstream& file_stream, std::uint64_t offset, const void* data,
+                        std::size_t size) {
+  static constexpr std::array<char, 64> kPadding{};
+
+  const auto position{static_cast<std::uint64_t>(file_stream.tellp())};
+  file_stream.write(kPadding.data(), static_cast<std::streamsize>(offset - position));
+  file_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+
+  return static_cast<bool>(file_stream);
+}
+}  // namespace detail
+
+// Writes the at, bt, rqt, cpus and id of `processes` in file order. With
+// `delta_arrivals`, arrivals are stored as 16-bit gaps when they are
+// non-decreasing and no gap exceeds 65535; otherwise they are stored as they
+// are. Fails on times that do not fit in 32 bits.
+template <typename P>
+bool WriteWorkloadFile(const std::filesystem::path& filepath, const std::vector<P>& processes,
+                       bool delta_arrivals = true) {
+  if constexpr (std::endian::native != std::endian::little) {
+    return false;
+  }
+
+  bool has_rqt{};
+  bool has_cpus{};
+  bool has_ids{};
+
+  for (std::size_t i = 0; i < processes.size(); i++) {
+    const auto& process{processes[i]};
+
+    for (const std::int64_t time : {static_cast<std::int64_t>(process.at),
+                                    static_cast<std::int64_t>(process.bt),
+                                    static_cast<std::int64_t>(process.rqt)}) {
+      if (time < std::numeric_limits<std::int32_t>::min() ||
+          time > std::numeric_limits<std::int32_t>::max()) {
+        return false;
+      }
+    }
+
+    has_rqt = has_rqt || process.rqt != 0;
+    has_cpus = has_cpus || process.cpus != 0;
+    has_ids = has_ids || process.id != i;
+  }
+
+  for (std::size_t i = 0; delta_arrivals && i < processes.size(); i++) {
+    const std::int64_t previous{i == 0 ? 0 : static_cast<std::int64_t>(processes[i - 1].at)};
+    const auto gap{static_cast<std::int64_t>(processes[i].at) - previous};
+
+    delta_arrivals = gap >= 0 && gap <= std::numeric_limits<std::uint16_t>::max();
+  }
+
+  std::vector<std::uint16_t> gaps{};
+  std::vector<std::int32_t> arrivals{};
+  std::vector<std::int32_t> bursts{};
+  std::vector<std::int32_t> requested{};
+  std::vector<std::uint32_t> processors{};
+  std::vector<std::uint64_t> ids{};
+
+  bursts.reserve(processes.size());
+
+  for (std::size_t i = 0; i < processes.size(); i++) {
+    const auto& process{processes[i]};
+
+    if (delta_arrivals) {
+      const auto previous{i == 0 ? 0 : processes[i - 1].at};
+      gaps.push_back(static_cast<std::uint16_t>(process.at - previous));
+    } else {
+      arrivals.push_back(static_cast<std::int32_t>(process.at));
+    }
+
+    bursts.push_back(static_cast<std::int32_t>(process.bt));
+
+    if (has_rqt) {
+      requested.push_back(static_cast<std::int32_t>(process.rqt));
+    }
+
+    if (has_cpus) {
+      processors.push_back(process.cpus);
+    }
+
+    if (has_ids) {
+      ids.push_back(process.id);
+    }
+  }
+
+  const std::size_t at_size{delta_arrivals ? gaps.size() * sizeof(std::uint16_t)
+                                           : arrivals.size() * sizeof(std::int32_t)};
+
+  WorkloadFileHeader header{.magic = WorkloadFileHeader::kMagic,
+                            .version = WorkloadFileHeader::kVersion,
+                            .flags = delta_arrivals ? WorkloadFileHeader::kDeltaArrivals : 0,
+                            .count = processes.size(),
+                            .at_offset = sizeof(WorkloadFileHeader)};
+
+  header.bt_offset = detail::AlignColumn(header.at_offset + at_size);
+
+  // Optional columns follow, each after the last one present.
+  std::uint64_t end{header.bt_offset + bursts.size() * sizeof(std::int32_t)};
+
+  const auto place = [&end](bool present, std::size_t size) -> std::uint64_t {
+    if (!present) {
+      return 0;
+    }
+
+    const auto offset{detail::AlignColumn(end)};
+    end = offset + size;
+
+    return offset;
+  };
+
+  header.rqt_offset = place(has_rqt, requested.size() * sizeof(std::int32_t));
+  header.cpus_offset = place(has_cpus, processors.size() * sizeof(std::uint32_t));
+  header.id_offset = place(has_ids, ids.size() * sizeof(std::uint64_t));
+
+  std::ofstream file_stream{filepath, std::ios::out | std::ios::binary | std::ios::trunc};
+  if (!file_stream) {
+    return false;
+  }
+
+  file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  const void* at_column{delta_arrivals ? static_cast<const void*>(gaps.data())
+                                       : static_cast<const void*>(arrivals.data())};
+
+  return detail::WriteColumn(file_stream, header.at_offset, at_column, at_size) &&
+         detail::WriteColumn(file_stream, header.bt_offset, bursts.data(),
+                             bursts.size() * sizeof(std::int32_t)) &&
+         (!has_rqt || detail::WriteColumn(file_stream, header.rqt_offset, requested.data(),
+                                          requested.size() * sizeof(std::int32_t))) &&
+         (!has_cpus || detail::WriteColumn(file_stream, header.cpus_offset, processors.data(),
+                                           processors.size() * sizeof(std::uint32_t))) &&
+         (!has_ids || detail::WriteColumn(file_stream, header.id_offset, ids.data(),
+                                          ids.size() * sizeof(std::uint64_t)));
+}
+
+// Read-only mapping of a ".psb" workload. It is a sized range of processes
+// (at, bt, rbt, rqt, cpus and id) decoded on the fly from the mapped columns,
+// so schedulers are built straight from the file with no intermediate vector:
+//   MappedWorkload workload{"big.psb"};
+//   SJFScheduler scheduler{workload};
+class MappedWorkload {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Process;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Process;
+
+    Iterator() = default;
+
+    Process operator*() const {
+      return {.at = at_,
+              .bt = bursts_[index_],
+              .rbt = bursts_[index_],
+              .id = ids_ ? static_cast<std::size_t>(ids_[index_]) : index_,
+              .rqt = requested_ ? requested_[index_] : 0,
+              .cpus = processors_ ? processors_[index_] : 0};
+    }
+
+    Iterator& operator++() {
+      index_++;
+      Decode();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto previous{*this};
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+
+   private:
+    friend class MappedWorkload;
+
+    Iterator(const MappedWorkload* workload, std::size_t index)
+        : arrivals_{workload->arrivals_},
+          gaps_{workload->gaps_},
+          bursts_{workload->bursts_},
+          requested_{workload->requested_},
+          processors_{workload->processors_},
+          ids_{workload->ids_},
+          count_{workload->count_},
+          index_{index} {
+      Decode();
+    }
+
+    // Loads the arrival of the current process (delta arrivals accumulate).
+    void Decode() {
+      if (index_ >= count_) {
+        return;
+      }
+
+      at_ = gaps_ ? at_ + gaps_[index_] : arrivals_[index_];
+    }
+
+    const std::int32_t* arrivals_{};
+    const std::uint16_t* gaps_{};
+    const std::int32_t* bursts_{};
+    const std::int32_t* requested_{};
+    const std::uint32_t* processors_{};
+    const std::uint64_t* ids_{};
+    std::size_t count_{};
+    std::size_t index_{};
+    int at_{};
+  };
+
+  explicit MappedWorkload(const std::filesystem::path& filepath) { Map(filepath); }
+
+  MappedWorkload(const MappedWorkload&) = delete;
+  MappedWorkload& operator=(const MappedWorkload&) = delete;
+
+  ~MappedWorkload() {
+    if (data_) {
+      munmap(data_, size_);
+    }
+  }
+
+  // False when the file is missing, truncated or not a ".psb" workload.
+  bool is_open() const { return data_ != nullptr; }
+
+  std::size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  Iterator begin() const { return {this, 0}; }
+  Iterator end() const { return {this, count_}; }
+
+ private:
+  void Map(const std::filesystem::path& filepath) {
+    if constexpr (std::endian::native != std::endian::little) {
+      return;
+    }
+
+    const int descriptor{open(filepath.c_str(), O_RDONLY)};
+    if (descriptor < 0) {
+      return;
+    }
+
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 ||
+        static_cast<std::size_t>(status.st_size) < sizeof(WorkloadFileHeader)) {
+      close(descriptor);
+      return;
+    }
+
+    size_ = static_cast<std::size_t>(status.st_size);
+    void* data{mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+    close(descriptor);
+
+    if (data == MAP_FAILED) {
+      return;
+    }
+
+    WorkloadFileHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+
+    const bool delta{(header.flags & WorkloadFileHeader::kDeltaArrivals) != 0};
+    // Written so that a crafted offset near 2^64 cannot wrap around; count is
+    // at most size_ / 2, so count * element_size cannot. Version 1 wrote zeros
+    // where the optional offsets are, so they read as absent.
+    const auto column_fits = [&](std::uint64_t offset, std::size_t element_size) {
+      return offset % 64 == 0 && offset <= size_ && header.count * element_size <= size_ - offset;
+    };
+
+    if (header.magic != WorkloadFileHeader::kMagic || header.version == 0 ||
+        header.version > WorkloadFileHeader::kVersion ||
+        header.count > size_ / sizeof(std::uint16_t) ||
+        !column_fits(header.at_offset, delta ? sizeof(std::uint16_t) : sizeof(std::int32_t)) ||
+        !column_fits(header.bt_offset, sizeof(std::int32_t)) ||
+        (header.rqt_offset != 0 && !column_fits(header.rqt_offset, sizeof(std::int32_t))) ||
+        (header.cpus_offset != 0 && !column_fits(header.cpus_offset, sizeof(std::uint32_t))) ||
+        (header.id_offset != 0 && !column_fits(header.id_offset, sizeof(std::uint64_t)))) {
+      munmap(data, size_);
+      return;
+    }
+
+    const auto* bytes{static_cast<const std::byte*>(data)};
+
+    // Delta arrivals accumulate in an int as they are decoded, so the last
+    // arrival must fit in one.
+    if (delta) {
+      const auto* gaps{reinterpret_cast<const std::uint16_t*>(bytes + header.at_offset)};
+
+      std::uint64_t last_arrival{};
+      for (std::uint64_t i = 0; i < header.count; i++) {
+        last_arrival += gaps[i];
+      }
+
+      if (last_arrival > static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max())) {
+        munmap(data, size_);
+        return;
+      }
+    }
+
+    // Read front to back, once.
+    madvise(data, size_, MADV_SEQUENTIAL);
+
+    data_ = data;
+    count_ = header.count;
+
+    if (delta) {
+      gaps_ = reinterpret_cast<const std::uint16_t*>(bytes + header.at_offset);
+    } else {
+      arrivals_ = reinterpret_cast<const std::int32_t*>(bytes + header.at_offset);
+    }
+
+    bursts_ = reinterpret_cast<const std::int32_t*>(bytes + header.bt_offset);
+
+    if (header.rqt_offset != 0) {
+      requested_ = reinterpret_cast<const std::int32_t*>(bytes + header.rqt_offset);
+    }
+
+    if (header.cpus_offset != 0) {
+      processors_ = reinterpret_cast<const std::uint32_t*>(bytes + header.cpus_offset);
+    }
+
+    if (header.id_offset != 0) {
+      ids_ = reinterpret_cast<const std::uint64_t*>(bytes + header.id_offset);
+    }
+  }
+
+  void* data_{};
+  std::size_t size_{};
+  std::size_t count_{};
+
+  const std::int32_t* arrivals_{};
+  const std::uint16_t* gaps_{};
+  const std::int32_t* bursts_{};
+  const std::int32_t* requested_{};
+  const std::uint32_t* processors_{};
+  const std::uint64_t* ids_{};
+};
+}  // namespace ps
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <ranges>
+
+namespace ps {
+// 64-bit hash of a workload: the arrival, burst, requested time, processor
+// count and id of every process, in range order, so any range of processes
+// (a vector, a MappedWorkload, a scheduler's table) with the same content
+// hashes the same whatever its Time type. It mixes one 64-bit word per field,
+// which keeps it at memory speed on workloads of millions of processes.
+//
+// Not cryptographic: it identifies workloads for checkpoints and cached
+// results, whose files also check the sizes they depend on.
+template <std::ranges::input_range Processes>
+std::uint64_t HashWorkload(const Processes& processes) {
+  constexpr std::uint64_t kMultiplier{0x9e3779b97f4a7c15ULL};
+
+  // Multiply-xorshift finalizer (from SplitMix64), one per word.
+  const auto mix = [](std::uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+  };
+
+  std::uint64_t hash{0x243f6a8885a308d3ULL};
+  std::uint64_t count{};
+
+  for (const auto& process : processes) {
+    const auto at{static_cast<std::uint64_t>(static_cast<std::int64_t>(process.at))};
+    const auto bt{static_cast<std::uint64_t>(static_cast<std::int64_t>(process.bt))};
+    const auto rqt{static_cast<std::uint64_t>(static_cast<std::int64_t>(process.rqt))};
+
+    hash = (hash ^ mix(at)) * kMultiplier;
+    hash = (hash ^ mix(bt)) * kMultiplier;
+    hash = (hash ^ mix(rqt ^ (static_cast<std::uint64_t>(process.cpus) << 32))) * kMultiplier;
+    hash = (hash ^ mix(static_cast<std::uint64_t>(process.id))) * kMultiplier;
+    count++;
+  }
+
+  return mix(hash ^ count);
+}
+}  // namespace ps